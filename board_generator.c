@@ -0,0 +1,270 @@
+#include<time.h>
+#include<pthread.h>
+#include<unistd.h>
+
+#include"board_generator.h"
+
+/**
+ * @brief State shared by the threads of a generation.
+ */
+struct generator_shared {
+    game_field *field;
+    int count;
+    const generator_options *options;
+    struct timespec deadline;
+
+    pthread_mutex_t lock;   /* guards everything below but done */
+    short *best;            /* values of the best board so far */
+    double best_distance;   /* its distance to the requested difficulty, or -1 */
+    double best_difficulty;
+    int qualified;
+    long candidates;
+    volatile int done;      /* set once a board qualified */
+};
+
+typedef struct generator_shared generator_shared;
+
+/**
+ * @brief State of one thread.
+ */
+struct generator_worker {
+    generator_shared *shared;
+    pthread_t thread;
+    game_random random;
+    short *values;
+    field_match *matches;
+    int capacity;
+};
+
+typedef struct generator_worker generator_worker;
+
+
+void init_generator_options(generator_options *options) {
+    options->threads = 0;
+    options->time_limit = 50;
+    options->playouts = 32;
+    options->difficulty = 0.5;
+    options->tolerance = 0.5;
+}
+
+static int is_generator_deadline_passed(const struct timespec *deadline) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec > deadline->tv_sec ||
+        (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+/**
+ * @brief Plays one game on a copy of the board.
+ *
+ * @return 1 if the game cleared the board.
+ */
+static int play_generator_game(generator_worker *worker, game_field *board) {
+    game_field *field;
+    field_match *first, *second;
+    int number, stop;
+
+    field = copy_game_field(board);
+
+    stop = 0;
+    while (!stop && !check_game_field_is_clear(field)) {
+        number = find_all_matches(field, NULL, 0);
+
+        if (number > worker->capacity) {
+            worker->capacity = number * 2;
+            worker->matches = (field_match*) realloc(worker->matches, worker->capacity * sizeof(field_match));
+        }
+        find_all_matches(field, worker->matches, number);
+
+        if (number > 0) {
+            first = worker->matches + next_game_random_range(&worker->random, 0, number - 1);
+            second = worker->matches + next_game_random_range(&worker->random, 0, number - 1);
+            if (second->type > first->type)
+                first = second;
+            play_game_field_match(field, &first->start, &first->end);
+        } else {
+            stop = !duplicate_game_field_cells(field);
+        }
+    }
+
+    stop = check_game_field_is_clear(field);
+    game_field_free(field);
+
+    return stop;
+}
+
+/**
+ * @brief Plays the games of a candidate.
+ *
+ * @return The number of games that cleared it, or -1 if the generation
+ *         ended before every game was played.
+ */
+static int evaluate_generator_board(generator_worker *worker, game_field *board) {
+    generator_shared *shared;
+    int res, i;
+
+    shared = worker->shared;
+    res = 0;
+
+    for (i = 0; i < shared->options->playouts && res >= 0; i++) {
+        if (shared->done || is_generator_deadline_passed(&shared->deadline))
+            res = -1;
+        else
+            res += play_generator_game(worker, board);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Keeps a solvable candidate if it qualifies or is the closest so far.
+ */
+static void record_generator_board(generator_worker *worker, double difficulty) {
+    generator_shared *shared;
+    double distance;
+    int i;
+
+    shared = worker->shared;
+    distance = difficulty - shared->options->difficulty;
+    if (distance < 0)
+        distance = -distance;
+
+    pthread_mutex_lock(&shared->lock);
+
+    if (!shared->qualified && (shared->best_distance < 0 || distance < shared->best_distance)) {
+        for (i = 0; i < shared->count; i++) {
+            shared->best[i] = worker->values[i];
+        }
+        shared->best_distance = distance;
+        shared->best_difficulty = difficulty;
+
+        if (distance <= shared->options->tolerance) {
+            shared->qualified = 1;
+            shared->done = 1;
+        }
+    }
+
+    pthread_mutex_unlock(&shared->lock);
+}
+
+static void* run_generator_worker(void *arg) {
+    generator_worker *worker;
+    generator_shared *shared;
+    game_field *board;
+    int i, cleared;
+
+    worker = (generator_worker*) arg;
+    shared = worker->shared;
+
+    while (!shared->done && !is_generator_deadline_passed(&shared->deadline)) {
+        for (i = 0; i < shared->count; i++) {
+            worker->values[i] = next_game_random_range(&worker->random, 1, 9);
+        }
+
+        board = create_new_game_field(shared->field->width);
+        board->additions_available = shared->field->additions_available;
+        add_values_game_field(board, worker->values, shared->count);
+
+        cleared = evaluate_generator_board(worker, board);
+        game_field_free(board);
+
+        if (cleared >= 0) {
+            pthread_mutex_lock(&shared->lock);
+            shared->candidates++;
+            pthread_mutex_unlock(&shared->lock);
+        }
+
+        if (cleared > 0)
+            record_generator_board(worker, 1 - (double) cleared / shared->options->playouts);
+    }
+
+    return NULL;
+}
+
+int generate_game_board(game_field *field, int count, const generator_options *options, generator_result *result) {
+    generator_shared shared;
+    generator_worker *workers;
+    game_random stream;
+    int i, threads, started;
+
+    threads = options->threads;
+    if (threads <= 0)
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+        threads = 1;
+
+    shared.field = field;
+    shared.count = count;
+    shared.options = options;
+    shared.best = (short*) malloc(count * sizeof(short));
+    shared.best_distance = -1;
+    shared.best_difficulty = 1;
+    shared.qualified = 0;
+    shared.candidates = 0;
+    shared.done = 0;
+    pthread_mutex_init(&shared.lock, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &shared.deadline);
+    shared.deadline.tv_sec += options->time_limit / 1000;
+    shared.deadline.tv_nsec += options->time_limit % 1000 * 1000000L;
+    if (shared.deadline.tv_nsec >= 1000000000L) {
+        shared.deadline.tv_sec++;
+        shared.deadline.tv_nsec -= 1000000000L;
+    }
+
+    /* the board takes a stream off the field's generator, and each thread
+     * its own part of that stream */
+    split_game_random(&field->random, &stream);
+
+    workers = (generator_worker*) malloc(threads * sizeof(generator_worker));
+    for (i = 0; i < threads; i++) {
+        workers[i].shared = &shared;
+        workers[i].random = i > 0 ? workers[i - 1].random : stream;
+        jump_game_random(&workers[i].random);
+        workers[i].values = (short*) malloc(count * sizeof(short));
+        workers[i].matches = NULL;
+        workers[i].capacity = 0;
+    }
+
+    /* the calling thread works as the first worker */
+    started = 1;
+    for (i = 1; started == i && i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, run_generator_worker, workers + i) == 0)
+            started++;
+    }
+
+    run_generator_worker(workers);
+
+    for (i = 1; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    /* no candidate could be cleared in time: a plain random board */
+    if (shared.best_distance < 0) {
+        for (i = 0; i < count; i++) {
+            shared.best[i] = next_game_random_range(&stream, 1, 9);
+        }
+    }
+
+    clear_game_field(field);
+    add_values_game_field(field, shared.best, count);
+
+    if (result != NULL) {
+        result->solvable = shared.best_distance >= 0;
+        result->qualified = shared.qualified;
+        result->difficulty = shared.best_difficulty;
+        result->candidates = shared.candidates;
+    }
+
+    for (i = 0; i < threads; i++) {
+        free(workers[i].values);
+        free(workers[i].matches);
+    }
+    free(workers);
+    free(shared.best);
+    pthread_mutex_destroy(&shared.lock);
+
+    return shared.qualified;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file board_generator.h
+ * @brief Generator of stage boards that are known to be clearable.
+ *
+ * Candidate boards are drawn at random, as init_game_field() draws them, and
+ * each one is played many times by a simple player (the better match type
+ * of two random pairs at each move, an addition when no pair is left). A
+ * board is solvable if one of those games clears it: that game is the proof.
+ * Its difficulty is the share of the games that did not clear it, from 0
+ * (every game clears it) to 1.
+ *
+ * Candidates are drawn from a stream split off the generator of the field
+ * (see split_game_random()), and each thread draws from its own part of
+ * it, so a board only depends on the seed of the field when a single
+ * thread generates it.
+ *
+ * Threads draw and play candidates in parallel; the first board that is
+ * solvable and close enough to the requested difficulty is kept. The search
+ * stops at a deadline, so that a stage change never waits long: the solvable
+ * board closest to the requested difficulty is used then, or a plain random
+ * board if no candidate could be cleared in time.
+ */
+
+#ifndef BOARD_GENERATOR_H
+#define BOARD_GENERATOR_H
+
+#include"game_objects/game_field.h"
+
+/**
+ * @brief Parameters of a generation.
+ */
+struct generator_options {
+    int threads;        /**< Number of threads; 0 uses every online core. */
+    long time_limit;    /**< Wall-clock limit of the generation, in milliseconds. */
+    int playouts;       /**< Games played on each candidate. */
+    double difficulty;  /**< Requested share of the games that fail, from 0 to 1. */
+    double tolerance;   /**< Accepted distance to the requested difficulty. */
+};
+
+typedef struct generator_options generator_options;
+
+/**
+ * @brief Outcome of a generation.
+ */
+struct generator_result {
+    int solvable;       /**< 1 if some game cleared the board. */
+    int qualified;      /**< 1 if the board is solvable and within the tolerance. */
+    double difficulty;  /**< Share of the games that did not clear the board. */
+    long candidates;    /**< Number of boards tried. */
+};
+
+typedef struct generator_result generator_result;
+
+/**
+ * @brief Fills the options with their default values.
+ *
+ * @param[out] options Pointer to the options to initialize.
+ *
+ * @details
+ * - every online core is used;
+ * - the generation lasts at most 50 ms;
+ * - 32 games are played on each candidate;
+ * - any solvable board is accepted (difficulty 0.5, tolerance 0.5).
+ */
+void init_generator_options(generator_options *options);
+
+/**
+ * @brief Replaces the cells of a field with a generated board.
+ *
+ * The games played on the candidates use the additions the field has left,
+ * which the board of a new stage gets back in full (see stage_pipeline.h).
+ *
+ * @param[in,out] field   Pointer to the game_field; its cells are replaced.
+ * @param[in]     count   Number of cells of the board.
+ * @param[in]     options Pointer to the generation parameters.
+ * @param[out]    result  Pointer receiving the outcome; may be NULL.
+ *
+ * @return int Returns 1 if the board qualified, 0 if the deadline forced a fallback.
+ */
+int generate_game_board(game_field *field, int count, const generator_options *options, generator_result *result);
+
+#endif /* BOARD_GENERATOR_H */
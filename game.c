@@ -1,50 +1,75 @@
 #include"game.h"
 
-short randshort(short start, short end) {
-    return start + rand() % (end - start + 1);
+void save_game(struct game_config *config) {
+    if (config->field->mapping != NULL)
+        sync_field_mapping(config->field, 1);
+    else if (config->autosave)
+        push_save_worker(&config->autosave_worker, config->field);
 }
 
-void expand_game_field(struct game_config *config) {
-    game_field *field;
-    field_cell *cell;
-    vector2i pos;
-    int i, old_count;
-
-    field = config->field;
+void save_game_move(struct game_config *config, const struct game_events *events) {
+    unsigned char record[GAME_LOG_RECORD_MAX];
+    const game_event *event;
+    size_t size;
+    int i;
 
-    if (field->additions_available > 0) {
+    /* a mapped save already holds the cells of the move */
+    if (config->field->mapping != NULL)
+        sync_field_mapping(config->field, 0);
+
+    for (i = 0; i < events->count && config->autosave && config->field->mapping == NULL; i++) {
+        event = events->items + i;
+
+        switch (event->type) {
+        case GAME_EVENT_MATCHED:
+            size = write_game_log_record(GAME_LOG_MATCH, event->start, event->end, record);
+            break;
+        case GAME_EVENT_HINT:
+            size = write_game_log_record(GAME_LOG_HINT, event->start, event->end, record);
+            break;
+        case GAME_EVENT_CELLS_ADDED:
+            size = write_game_log_record(GAME_LOG_EXPAND, event->start, event->end, record);
+            break;
+        default:
+            size = 0;
+            break;
+        }
 
-        old_count = field->count;
+        if (size > 0)
+            push_save_worker_move(&config->autosave_worker, config->field, record, size);
+    }
+}
 
-        for (i = 0; i < old_count; i++) {
-            pos.x = i % field->width;
-            pos.y = i / field->width;
+void expand_game_field(struct game_config *config) {
+    game_command command;
+    game_events events;
 
-            cell = get_game_field_cell(field, pos);
+    command = create_game_command(GAME_COMMAND_EXPAND, config->cursor_p);
 
-            if (cell->is_available) {
-                add_values_game_field(field, &cell->value, 1);
-            }
-        }
-
-        field->additions_available--;
-    } else {
+    if (!apply_game_command(config, &command, &events)) {
         config->output->show_game_message("No addditions available");
     }
-    serialize_game_field(field, "save.bin");
+    save_game_move(config, &events);
 }
 
-void update_stage(game_field *field) {
-    
-    field->stage++;
-    field->score += CLEAR_FIELD_MATCH;
-            
-    field->additions_available = field->additions_max;
-    field->hints_available = field->hints_max;
-            
-    init_game_field(field);
+void start_next_game_stage(struct game_config *config) {
+    game_random stream;
+
+    split_game_random(&config->field->random, &stream);
+    start_stage_pipeline(&config->next_stage, config->field->width, config->field->additions_max,
+                         &stream, config->solvable_boards, &config->generator);
+}
+
+void start_game_stage(struct game_config *config, field_journal *journal, field_mapping *mapping) {
+    /* moves are not undone across a stage change */
+    config->field->journal = journal;
+    if (journal != NULL)
+        clear_field_journal(journal);
+
+    config->field->mapping = mapping;
+    reset_field_mapping(config->field);
 
-    serialize_game_field(field, "save.bin");
+    start_next_game_stage(config);
 }
 
 int check_game_is_over(game_field *field) {
@@ -62,96 +87,133 @@ int check_game_is_over(game_field *field) {
 }
 
 void show_game_hints(struct game_config *config) {
-    vector2i pos1, pos2;
-    game_field *field;
+    game_command command;
+    game_events events;
 
-    field = config->field;
+    command = create_game_command(GAME_COMMAND_HINT, config->cursor_p);
+    apply_game_command(config, &command, &events);
 
-    if (field->hints_available <= 0) {
+    if (find_game_event(&events, GAME_EVENT_NO_HINTS) != NULL) {
         config->output->show_game_message("No hints available ");
-    } else if (find_match(field, &pos1, &pos2)) {
-        set_highlight_game_field_cell(field, pos1, 1);
-        set_highlight_game_field_cell(field, pos2, 1);
-        field->hints_available--;
-    } else {
+    } else if (find_game_event(&events, GAME_EVENT_NO_MATCH) != NULL) {
         config->output->show_game_message("No match finded");
     }
-    serialize_game_field(field, "save.bin");
+    save_game_move(config, &events);
 }
 
 MATCH_TYPE user_game_select(struct game_config *config) {
-    game_field *field;
-    vector2i *cursor_p, *selected_p;
+    game_command command;
+    game_events events;
+    const game_event *matched;
     MATCH_TYPE match_res;
 
-    field = config->field;
-    cursor_p = &config->cursor_p;
-    selected_p = &config->selected_p;
+    command = create_game_command(GAME_COMMAND_SELECT, config->cursor_p);
+    apply_game_command(config, &command, &events);
 
-    match_res = NONE_MATCH;
-    
-    /* - If a cell is already selected */
-    if (selected_p->x != -1) {
-        /* - Deselects it temporarily. */ 
-        set_selection_game_field_cell(field, *selected_p, 0);
+    matched = find_game_event(&events, GAME_EVENT_MATCHED);
 
-        /* - Checks if the current cursor position matches the previously selected cell. */
-        match_res = check_match(field, *selected_p, *cursor_p);
-        
-        /* - If the same cell is clicked again, cancels the selection. */
-        if (cursor_p->x == selected_p->x && cursor_p->y == selected_p->y) {
-            selected_p->x = -1;
-        /* - If a valid match is found, removes both cells, updates the score,  
-           clears completed rows, and repositions the cursor.  */
-        } else if (match_res) {
-
-            set_available_game_field_cell(field, *selected_p, 0);
-            set_available_game_field_cell(field, *cursor_p, 0);
-
-            if (check_game_row_is_clear(field, cursor_p->y)) {
-                remove_game_field_row(field, cursor_p->y);
-                match_res += CLEAR_LINE_MATCH;
-                
-                if (selected_p->y > cursor_p->y)
-                    selected_p->y--;
-                
-                cursor_p->y--;
-            }
-            
-            if (check_game_row_is_clear(field, selected_p->y)) {
-                remove_game_field_row(field, selected_p->y);
-                match_res += CLEAR_LINE_MATCH;
-                cursor_p->y--;
-            }
-
-            if (cursor_p->y < 0) cursor_p->y = 0;
-
-            selected_p->x = -1;
-
-            field->score += match_res;
-            serialize_game_field(field, "save.bin");
-        /* - If is a not valide match select current cursor position */
-        } else {
-            *selected_p = *cursor_p; 
-            set_selection_game_field_cell(field, *selected_p, 1);         
-        }
-    /* - If no cell is currently selected */
+    /* - A played pair: the cursor follows its cell up the removed rows. */
+    if (matched != NULL) {
+        match_res = matched->value;
+
+        config->cursor_p.y -= count_game_events(&events, GAME_EVENT_ROW_REMOVED);
+        if (config->cursor_p.y < 0) config->cursor_p.y = 0;
+
+        save_game_move(config, &events);
+    /* - A cancelled selection, or a second cell that does not match. */
+    } else if (find_game_event(&events, GAME_EVENT_UNSELECTED) != NULL) {
+        match_res = NOT_MATCH;
+    /* - A first selection. */
     } else {
-        *selected_p = *cursor_p;
-        set_selection_game_field_cell(field, *selected_p, 1);
+        match_res = NONE_MATCH;
     }
 
     return match_res;
 }
 
+/**
+* @brief Undoes or redoes a move and shows @p message if there is none.
+*/
+static void replay_game_move(struct game_config *config, GAME_COMMAND_TYPE type, const char *message) {
+    game_command command;
+    game_events events;
+
+    command = create_game_command(type, config->cursor_p);
+
+    if (apply_game_command(config, &command, &events)) {
+        /* the cell of the cursor may be gone */
+        if (get_game_field_cell(config->field, config->cursor_p) == NULL)
+            config->cursor_p = create_vector2i(0, 0);
+        save_game(config);
+    } else {
+        config->output->show_game_message(message);
+    }
+}
+
+void undo_game_move(struct game_config *config) {
+    replay_game_move(config, GAME_COMMAND_UNDO, "Nothing to undo");
+}
+
+void redo_game_move(struct game_config *config) {
+    replay_game_move(config, GAME_COMMAND_REDO, "Nothing to redo");
+}
+
+/**
+* @brief Adds the game that ended to the scores.
+*/
+static void add_game_score(struct game_config *config, time_t started) {
+    score_entry entry;
+    time_t now;
+
+    now = time(NULL);
+
+    entry.score = config->field->score;
+    entry.stage = config->field->stage;
+    entry.duration = (unsigned long) difftime(now, started);
+    entry.seed = config->field->random.seed;
+    entry.timestamp = (unsigned long) now;
+
+    /* a front end without a menu has not loaded the store */
+    load_score_board(&config->scores, "scores.bin");
+    add_score_board_entry(&config->scores, &entry);
+}
+
 void game_cycle(struct game_config *config) {
-    int best_score;
+    game_command command;
+    game_events events;
+    field_journal *journal;
+    field_mapping *mapping;
+    time_t started;
+
+    started = time(NULL);
 
-    serialize_game_field(config->field, "save.bin");
+    if (config->autosave && config->save_mode == SAVE_MODE_MAP) {
+        config->field->mapping = create_field_mapping("save.bin");
+
+        if (!reset_field_mapping(config->field)) {
+            free_field_mapping(config->field->mapping);
+            config->field->mapping = NULL;
+        }
+    }
+
+    if (config->autosave && config->field->mapping == NULL)
+        start_save_worker(&config->autosave_worker, "save.bin", "save.log");
+
+    if (config->autosave)
+        start_game_replay(&config->replay, "replay.bin", config->field);
+
+    save_game(config);
     
     config->selected_p.x = -1;
     config->cursor_p = create_vector2i(0, 0);
 
+    /* kept here: the engine leaves them with the cleared field of a stage */
+    journal = create_field_journal(FIELD_JOURNAL_DEFAULT_LIMIT);
+    mapping = config->field->mapping;
+    config->field->journal = journal;
+
+    start_next_game_stage(config);
+
     do {
         set_cursor_game_field_cell(config->field, config->cursor_p, 1);
 
@@ -161,23 +223,39 @@ void game_cycle(struct game_config *config) {
 
         config->output->update_game(config);
 
-        if (check_game_field_is_clear(config->field)) {
-            update_stage(config->field);
+        command = create_game_command(GAME_COMMAND_NEW_STAGE, config->cursor_p);
+        if (apply_game_command(config, &command, &events)) {
+            start_game_stage(config, journal, mapping);
+            save_game(config);
+
+            /* the replay is written once a stage, not on every input */
+            flush_game_replay(&config->replay);
         }
 
     } while (!check_game_is_over(config->field) && !config->exit);
 
-    
+    stop_stage_pipeline(&config->next_stage);
+
+    free_field_journal(journal);
+    config->field->journal = NULL;
+
+    /* the last save and moves are written before they are removed or loaded again */
+    stop_save_worker(&config->autosave_worker);
+    free_field_mapping(mapping);
+    config->field->mapping = NULL;
+
+    stop_game_replay(&config->replay, config->field);
+
     if (!config->exit) {
         config->output->display_game(config);
 
         config->output->end_game_message(config);
+    }
 
-        best_score = deserialize_game_score("score.bin");
-        if (config->field->score > best_score) {
-            serialize_game_score("score.bin", config->field->score);
-        }
+    if (!config->exit && config->autosave) {
+        add_game_score(config, started);
 
+        remove("save.log");
         remove("save.bin");
     }
     config->exit = 0;
@@ -188,14 +266,22 @@ void init_game_field(game_field *field) {
     int i;
 
     for(i = 0; i < INIT_CELLS_COUNT; i++) {
-        values[i] = randshort(1, 9);
+        values[i] = next_game_random_range(&field->random, 1, 9);
     }
 
-    while (get_game_field_height(field) > 0) remove_game_field_row(field, 0);
+    clear_game_field(field);
     
     add_values_game_field(field, values, INIT_CELLS_COUNT);
 }
 
+void init_stage_game_field(struct game_config *config) {
+    if (config->solvable_boards) {
+        generate_game_board(config->field, INIT_CELLS_COUNT, &config->generator, NULL);
+    } else {
+        init_game_field(config->field);
+    }
+}
+
 void load_game(struct game_config *config) {
 
     /* free any previously allocated field to avoid memory leaks */
@@ -204,7 +290,7 @@ void load_game(struct game_config *config) {
     }
 
     /* attempt to load saved game data */
-    if ((config->field = deserialize_game_field("save.bin")) == NULL) {
+    if ((config->field = deserialize_game_save("save.bin", "save.log")) == NULL) {
         config->output->show_game_message("Error while loading game!");
     } else {
         game_cycle(config);
@@ -224,7 +310,10 @@ void start_game(struct game_config *config) {
     /* create a new game field with width 9 */
     config->field = create_new_game_field(GRID_WIDTH);
 
-    init_game_field(config->field);
+    /* every game has its own seed, drawn from the seeds of the session */
+    seed_game_random(&config->field->random, next_game_random(&config->random));
+
+    init_stage_game_field(config);
     game_cycle(config);
 
     game_field_free(config->field); 
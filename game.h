@@ -22,19 +22,48 @@
 #include<unistd.h>
 #include<stdlib.h>
 #include<stdio.h>
+#include<time.h>
 
 #include"game_config.h"
 #include"serializer.h"
+#include"hint_search.h"
+#include"game_engine.h"
+#include"game_objects/field_journal.h"
+#include"game_objects/field_mapping.h"
+
+struct game_events;
+
+/**
+* @brief Saves the current game field to "save.bin".
+*
+* @param[in] config Pointer to the game_config structure containing the current field.
+*
+* @details
+* - Does nothing if @p config->autosave is 0, so that automated games
+*   do not replace the player's saved game.
+* - Returns once the save is copied: the file is written in the background
+*   by @p config->autosave_worker, started by game_cycle().
+* - In SAVE_MODE_MAP, the file already holds the cells: its header is
+*   written in place and the file is synced to the disk.
+*/
+void save_game(struct game_config *config);
 
 /**
-* @brief Generates a random short integer within the specified range.
+* @brief Appends the move reported by @p events to "save.log".
 *
-* @param[in] start Lower bound of the range (inclusive).
-* @param[in] end   Upper bound of the range (inclusive).
+* @param[in] config Pointer to the game_config structure containing the current field.
+* @param[in] events Pointer to the events of the move (see game_engine.h).
 *
-* @return short A random short value between start and end.
+* @details
+* - A played pair, a hint and an addition are logged in a few bytes
+*   (see serializer.h); other events are not moves and are ignored.
+* - The field is saved whole instead once the log has grown past the
+*   size of the save.
+* - In SAVE_MODE_MAP, only writes the header in place and schedules the
+*   write of the file (see field_mapping.h).
+* - Does nothing if @p config->autosave is 0.
 */
-short randshort(short start, short end);
+void save_game_move(struct game_config *config, const struct game_events *events);
 
 /**
 * @brief Expands the current game field by duplicating values from available cells.
@@ -47,23 +76,38 @@ short randshort(short start, short end);
 *   and appends them to the bottom of the game field.
 * - Decreases the count of available additions by one.
 * - If no additions are available, displays a warning message via the output strategy.
-* - Saves the updated game field state to "save.bin".
+* - Logs the addition to "save.log" (see save_game_move()).
 */
 void expand_game_field(struct game_config *config);
 
 /**
-* @brief Advances the game to the next stage and resets stage-related parameters.
+* @brief Starts building the board that follows the current stage.
 *
-* @param[in,out] field Pointer to the game_field structure.
+* @param[in,out] config Pointer to the game_config structure containing the current field.
 *
 * @details
-* - Increments the current stage number.
-* - Adds points to the score for clearing the field (CLEAR_FIELD_MATCH).
-* - Resets the number of available additions and hints to their maximum values.
-* - Reinitializes the game field with new random values.
-* - Saves the updated game state to "save.bin".
+* - The board is built in the background by @p config->next_stage (see
+*   stage_pipeline.h), from a stream split off the generator of the field
+*   (see split_game_random()).
+* - GAME_COMMAND_NEW_STAGE takes it when the field is cleared.
 */
-void update_stage(game_field *field);
+void start_next_game_stage(struct game_config *config);
+
+/**
+* @brief Sets up a stage the engine started, on GAME_EVENT_STAGE_STARTED.
+*
+* @param[in,out] config  Pointer to the game_config structure holding the new field.
+* @param[in,out] journal Journal of the game, or NULL; it is cleared.
+* @param[in,out] mapping Mapped save of the game, or NULL; it is rewritten for the new field.
+*
+* @details
+* - The engine only swaps the field (see apply_game_command()): the new
+*   stage number, score, additions and hints are set, and the journal and
+*   the save of the game are still attached to the cleared field.
+* - Moves are not undone across a stage change.
+* - Starts building the board of the following stage.
+*/
+void start_game_stage(struct game_config *config, field_journal *journal, field_mapping *mapping);
 
 /**
 * @brief Checks whether the game has ended.
@@ -81,9 +125,11 @@ int check_game_is_over(game_field *field);
 *
 * @details
 * - If no hints are available, shows a "No hints available" message.
+* - Looks for the pair with the best expected outcome for @p config->hint_time
+*   milliseconds (see hint_search.h), or takes the first pair if it is 0.
 * - If a matching pair is found, highlights both cells and decreases the number of available hints by one.
 * - If no match exists, shows a "No match found" message.
-* - Saves the updated game field state to "save.bin".
+* - Logs the hint to "save.log" (see save_game_move()).
 */
 void show_game_hints(struct game_config *config);
 
@@ -94,14 +140,58 @@ void show_game_hints(struct game_config *config);
 *                       cursor position, and selected cell position.
 *
 * @return MATCH_TYPE value representing the result of the user's selection.
+*
+* @details
+* - Applies a GAME_COMMAND_SELECT on the cursor (see game_engine.h).
+* - After a played pair, moves the cursor up the removed rows and logs the
+*   pair to "save.log" (see save_game_move()).
 */
 MATCH_TYPE user_game_select(struct game_config *config);
 
+/**
+* @brief Undoes the last move of the current stage.
+*
+* @param[in,out] config Pointer to the game_config structure containing the current field.
+*
+* @details
+* - A move is a played pair, an addition or a hint; its cells, score and
+*   counters are restored from the journal of the field (see field_journal.h).
+* - Cancels the current selection and moves the cursor back to the first
+*   cell if its cell no longer exists.
+* - If there is no move to undo, shows a message via the output strategy.
+* - Saves the updated game field state to "save.bin" (see save_game()).
+*/
+void undo_game_move(struct game_config *config);
+
+/**
+* @brief Plays again the last undone move.
+*
+* @param[in,out] config Pointer to the game_config structure containing the current field.
+*
+* @details
+* - Any new move forgets the undone ones.
+* - Otherwise behaves like undo_game_move().
+*/
+void redo_game_move(struct game_config *config);
+
 /**
 * @brief Runs the main game loop.
 *
 * @param[in,out] config Pointer to the game_config structure containing the current
 *                       game state, field, score, and output settings.
+*
+* @details
+* - Starts the next stage with a GAME_COMMAND_NEW_STAGE once the field is cleared.
+* - Builds the board of the next stage in the background while a stage is played.
+* - Records the moves of each stage in a journal, so that they can be undone.
+* - Saves the game after every stage change. The saves are written in the
+*   background and the last one is on the disk when the loop ends.
+* - Records the game to "replay.bin" (see game_replay.h), unless
+*   @p config->autosave is 0; the replay is kept when the game ends.
+* - When the game ends, adds it to the scores of @p config->scores (see
+*   score_board.h) and removes "save.bin" and "save.log", unless
+*   @p config->autosave is 0. The duration of a loaded game counts from
+*   its load.
 */
 void game_cycle(struct game_config *config);
 
@@ -111,14 +201,28 @@ void game_cycle(struct game_config *config);
 * @param[in,out] field Pointer to the game_field structure to be initialized.
 *
 * @details
-* - Generates **INIT_CELLS_COUNT** random values in the range [1, 9].
+* - Generates **INIT_CELLS_COUNT** random values in the range [1, 9], drawn
+*   from the generator of the field.
 * - Clears the current game field by removing all existing rows.
 * - Adds the generated values to the field to start a new game state.
 */
 void init_game_field(struct game_field *field);
 
 /**
-* @brief Loads a saved game from "save.bin" and starts the main game loop.
+* @brief Fills the game field with the board of a new stage.
+*
+* @param[in,out] config Pointer to the game_config structure containing the current field.
+*
+* @details
+* - If @p config->solvable_boards is set, generates a board known to be clearable
+*   with generate_game_board() and @p config->generator.
+* - Otherwise, draws random values with init_game_field().
+*/
+void init_stage_game_field(struct game_config *config);
+
+/**
+* @brief Loads a saved game from "save.bin", plays again the moves of
+*        "save.log", and starts the main game loop.
 * 
 * @param[in,out] config Pointer to the game_config structure. On input, it may contain
 *                       initial configuration; on output, it will be updated with
@@ -128,6 +232,8 @@ void load_game(struct game_config *config);
 
 /**
 * @brief Starts a new game by creating a fresh game field and running the main game loop.
+*
+* The field is seeded with the next number of @p config->random.
 * 
 * @param[in,out] config Pointer to the game_config structure. On input, it may contain
 *                        initial settings; on output, it will be initialized with a
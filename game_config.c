@@ -11,6 +11,16 @@ struct game_config* create_game_config() {
     res->selected_p = create_vector2i(-1, 0);
     res->shift = 0;
     res->exit = 0;
+    res->autosave = 1;
+    res->save_mode = SAVE_MODE_LOG;
+    res->hint_time = DEFAULT_HINT_TIME;
+    res->solvable_boards = 0;
+    init_generator_options(&res->generator);
+    init_stage_pipeline(&res->next_stage);
+    init_save_worker(&res->autosave_worker);
+    init_game_replay(&res->replay);
+    init_score_board(&res->scores);
+    seed_game_random(&res->random, 0);
 
     return res;
 }
@@ -18,10 +28,12 @@ struct game_config* create_game_config() {
 void free_game_config(struct game_config *config) {
 
     if (config->field != NULL)
-        free(config->field);
+        game_field_free(config->field);
 
     if (config->output != NULL)
-        free(config->field);
+        free(config->output);
 
+    free_game_replay(&config->replay);
+    free_score_board(&config->scores);
     free(config);
 }
\ No newline at end of file
@@ -13,10 +13,29 @@
 
 #include "game_objects/game_field.h"
 #include "game_objects/vector2i.h"
+#include "board_generator.h"
+#include "stage_pipeline.h"
+#include "save_worker.h"
+#include "game_replay.h"
+#include "score_board.h"
 #include "output_strategies/output_config.h"
 
 struct output_config;
 
+/**
+ * @brief Default time budget of a hint search, in milliseconds.
+ */
+#define DEFAULT_HINT_TIME 20
+
+/**
+ * @brief How "save.bin" is kept up to date during a game.
+ */
+enum SAVE_MODE {
+    SAVE_MODE_LOG = 0,  /**< Moves appended to "save.log" by a background writer, see save_worker.h */
+    SAVE_MODE_MAP = 1   /**< Cells written in place in the mapped file, see field_mapping.h */
+};
+typedef enum SAVE_MODE SAVE_MODE;
+
 /**
  * @brief Holds the current state and configuration of the NumberMatch game.
  *
@@ -29,6 +48,16 @@ struct output_config;
  * - **cursor_p** — current cursor position in the grid
  * - **selected_p** — selected cell position; (-1, -1) means nothing is selected
  * - **shift** — horizontal rendering offset
+ * - **autosave** — whether the game keeps "save.bin", "scores.bin" and "replay.bin" up to date
+ * - **save_mode** — how "save.bin" is written
+ * - **hint_time** — time a hint may spend looking for a good pair
+ * - **solvable_boards** / **generator** — whether and how stage boards are
+ *   generated with a guaranteed solution (see board_generator.h)
+ * - **next_stage** — board of the next stage, built in the background
+ * - **autosave_worker** — writes "save.bin" in the background during a game
+ * - **replay** — records the game to "replay.bin" (see game_replay.h)
+ * - **scores** — scores of the finished games, loaded by the menus (see score_board.h)
+ * - **random** — generator drawing the seed of each new game
  */
 struct game_config {
     game_field *field;                 /**< Game field containing all cells */
@@ -37,6 +66,16 @@ struct game_config {
     vector2i selected_p;               /**< Position of selected cell (or -1, -1) */
     int shift;                         /**< Horizontal shift for UI layout */
     int exit;                          /**< Flag to exit the game */
+    int autosave;                      /**< 0 to play without touching the save files */
+    SAVE_MODE save_mode;               /**< How the save is written during a game */
+    long hint_time;                    /**< Hint search budget in ms; 0 shows the first pair */
+    int solvable_boards;               /**< 1 to generate boards known to be clearable */
+    generator_options generator;       /**< Parameters of the board generator */
+    stage_pipeline next_stage;         /**< Board of the next stage, built while this one is played */
+    save_worker autosave_worker;       /**< Writer of "save.bin", running during a game */
+    game_replay replay;                /**< Replay recorded during a game */
+    score_board scores;                /**< Scores of the finished games */
+    game_random random;                /**< Seeds of the games of the session */
 };
 
 /**
@@ -48,6 +87,15 @@ struct game_config {
  * - `cursor_p`   → (0, 0)  
  * - `selected_p` → (-1, -1)  
  * - `shift`      → 0  
+ * - `autosave`   → 1  
+ * - `save_mode`  → SAVE_MODE_LOG  
+ * - `hint_time`  → DEFAULT_HINT_TIME  
+ * - `solvable_boards` → 0, `generator` → init_generator_options()  
+ * - `next_stage` → empty  
+ * - `autosave_worker` → stopped  
+ * - `replay`     → not recording  
+ * - `scores`     → empty, without a store  
+ * - `random`     → seeded with 0  
  *
  * @return Pointer to a newly created `game_config` structure.
  */
@@ -60,6 +108,7 @@ struct game_config* create_game_config();
  * @details
  * - Frees the game field if allocated.
  * - Frees the output strategy if allocated.
+ * - Writes the scores not written yet.
  * - Frees the `game_config` structure itself.
  *
  * @param config Pointer to the configuration object to destroy.
@@ -0,0 +1,347 @@
+#include"game_engine.h"
+#include"game.h"
+
+
+game_command create_game_command(GAME_COMMAND_TYPE type, vector2i pos) {
+    game_command res;
+
+    res.type = type;
+    res.pos = pos;
+    res.end = pos;
+
+    return res;
+}
+
+static void push_game_event(game_events *events, GAME_EVENT_TYPE type, vector2i start, vector2i end, int value) {
+    game_event *event;
+
+    if (events->count < GAME_EVENTS_MAX) {
+        event = events->items + events->count++;
+        event->type = type;
+        event->start = start;
+        event->end = end;
+        event->value = value;
+    }
+}
+
+/**
+ * @brief Checks whether a row has no available cell once two cells are crossed out.
+ */
+static int check_game_engine_row_cleared(game_field *field, int row, vector2i start, vector2i end) {
+    field_cell *cells;
+    int res, i, size;
+
+    cells = get_game_field_row(field, row);
+    size = get_game_field_row_size(field, row);
+
+    res = size > 0;
+    for (i = 0; i < size && res; i++) {
+        if (FIELD_CELL_IS_AVAILABLE(cells[i]) &&
+            !(row == start.y && i == start.x) && !(row == end.y && i == end.x))
+            res = 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Finds the rows play_game_field_match() removes when it plays a pair,
+ *        as it numbers them when it removes them.
+ *
+ * @return The number of rows written to @p rows.
+ */
+static int find_game_engine_removed_rows(game_field *field, vector2i start, vector2i end, int rows[2]) {
+    int res, row;
+
+    res = 0;
+
+    if (check_game_engine_row_cleared(field, end.y, start, end))
+        rows[res++] = end.y;
+
+    /* the row of the first cell, numbered after the removal of the second's */
+    row = start.y;
+    if (res > 0 && start.y > end.y)
+        row--;
+
+    if (check_game_engine_row_cleared(field, res > 0 && row >= end.y ? row + 1 : row, start, end))
+        rows[res++] = row;
+
+    return res;
+}
+
+static int select_game_engine_cell(struct game_config *config, vector2i pos, game_events *events) {
+    game_field *field;
+    vector2i start, end;
+    int res, i, rows_count, rows[2];
+    MATCH_TYPE points;
+
+    field = config->field;
+    res = get_game_field_cell(field, pos) != NULL;
+
+    if (res && config->selected_p.x != -1) {
+        set_selection_game_field_cell(field, config->selected_p, 0);
+
+        if (pos.x == config->selected_p.x && pos.y == config->selected_p.y) {
+            push_game_event(events, GAME_EVENT_UNSELECTED, config->selected_p, pos, 0);
+            config->selected_p.x = -1;
+        } else {
+            start = config->selected_p;
+            end = pos;
+            rows_count = find_game_engine_removed_rows(field, start, end, rows);
+
+            if ((points = play_game_field_match(field, &start, &end))) {
+                push_game_event(events, GAME_EVENT_MATCHED, config->selected_p, pos, points);
+                for (i = 0; i < rows_count; i++) {
+                    push_game_event(events, GAME_EVENT_ROW_REMOVED, config->selected_p, pos, rows[i]);
+                }
+                events->score += points;
+                config->selected_p.x = -1;
+            } else {
+                push_game_event(events, GAME_EVENT_UNSELECTED, config->selected_p, pos, 0);
+                config->selected_p = pos;
+                set_selection_game_field_cell(field, pos, 1);
+                push_game_event(events, GAME_EVENT_SELECTED, pos, pos, 0);
+            }
+        }
+    } else if (res) {
+        config->selected_p = pos;
+        set_selection_game_field_cell(field, pos, 1);
+        push_game_event(events, GAME_EVENT_SELECTED, pos, pos, 0);
+    }
+
+    return res;
+}
+
+static int expand_game_engine_field(struct game_config *config, game_events *events) {
+    game_field *field;
+    int res, count;
+
+    field = config->field;
+    count = (int) field->table->count;
+
+    res = duplicate_game_field_cells(field);
+
+    if (res)
+        push_game_event(events, GAME_EVENT_CELLS_ADDED, config->selected_p, config->selected_p,
+                        (int) field->table->count - count);
+    else
+        push_game_event(events, GAME_EVENT_NO_ADDITIONS, config->selected_p, config->selected_p, 0);
+
+    return res;
+}
+
+/**
+ * @brief Finds the pair a hint shows: the best one the search finds in the
+ *        time budget, or the first one when there is no budget.
+ */
+static int find_game_engine_hint(struct game_config *config, vector2i *pos1, vector2i *pos2) {
+    hint_options options;
+    int res;
+
+    if (config->hint_time > 0) {
+        init_hint_options(&options);
+        options.time_budget = config->hint_time;
+        res = search_game_field_hint(config->field, &options, pos1, pos2);
+    } else {
+        res = find_match(config->field, pos1, pos2);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Highlights the pair a hint found, or the pair of a GAME_COMMAND_HINT_PAIR
+ *        when @p command is not NULL.
+ */
+static int show_game_engine_hint(struct game_config *config, const game_command *command, game_events *events) {
+    game_field *field;
+    vector2i pos1, pos2;
+    int res, found;
+
+    field = config->field;
+    res = 0;
+
+    if (field->hints_available <= 0) {
+        push_game_event(events, GAME_EVENT_NO_HINTS, config->selected_p, config->selected_p, 0);
+    } else {
+        if (command != NULL) {
+            pos1 = command->pos;
+            pos2 = command->end;
+            /* a recorded hint only shows a pair that can still be played */
+            found = check_match(field, pos1, pos2) != NOT_MATCH;
+        } else {
+            found = find_game_engine_hint(config, &pos1, &pos2);
+        }
+
+        if (found) {
+            set_highlight_game_field_cell(field, pos1, 1);
+            set_highlight_game_field_cell(field, pos2, 1);
+            field->hints_available--;
+            push_game_event(events, GAME_EVENT_HINT, pos1, pos2, 0);
+            res = 1;
+        } else {
+            push_game_event(events, GAME_EVENT_NO_MATCH, config->selected_p, config->selected_p, 0);
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Cancels the selection, whose cell may have moved or disappeared.
+ */
+static void reset_game_engine_selection(struct game_config *config, game_events *events) {
+    if (config->selected_p.x != -1) {
+        set_selection_game_field_cell(config->field, config->selected_p, 0);
+        push_game_event(events, GAME_EVENT_UNSELECTED, config->selected_p, config->selected_p, 0);
+        config->selected_p.x = -1;
+    }
+}
+
+static int replay_game_engine_move(struct game_config *config, int undo, game_events *events) {
+    int res, score;
+
+    score = config->field->score;
+    res = undo ? undo_field_journal(config->field) : redo_field_journal(config->field);
+
+    if (res) {
+        reset_game_engine_selection(config, events);
+        push_game_event(events, undo ? GAME_EVENT_UNDONE : GAME_EVENT_REDONE,
+                        config->selected_p, config->selected_p, 0);
+        events->score += config->field->score - score;
+    } else {
+        push_game_event(events, undo ? GAME_EVENT_NOTHING_TO_UNDO : GAME_EVENT_NOTHING_TO_REDO,
+                        config->selected_p, config->selected_p, 0);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Replaces the cleared field with the board of the next stage.
+ *
+ * Only the field is swapped: the journal and the save the front end attached
+ * to the cleared field are not carried over, the front end attaches them to
+ * the new field on GAME_EVENT_STAGE_STARTED.
+ *
+ * @return 1 if the board was there, 0 if no board was being built.
+ */
+static int swap_game_engine_field(struct game_config *config) {
+    game_field *field, *board;
+
+    field = config->field;
+    board = take_stage_pipeline_board(&config->next_stage);
+
+    if (board != NULL) {
+        board->stage = field->stage + 1;
+        board->score = field->score + CLEAR_FIELD_MATCH;
+
+        board->additions_max = field->additions_max;
+        board->additions_available = field->additions_max;
+        board->hints_max = field->hints_max;
+        board->hints_available = field->hints_max;
+
+        /* the generator goes on: every board and search split its stream off it */
+        board->random = field->random;
+
+        game_field_free(field);
+        config->field = board;
+    }
+
+    return board != NULL;
+}
+
+static int start_game_engine_stage(struct game_config *config, game_events *events) {
+    int res;
+
+    res = check_game_field_is_clear(config->field) && swap_game_engine_field(config);
+
+    if (res) {
+        config->selected_p.x = -1;
+        push_game_event(events, GAME_EVENT_STAGE_STARTED, config->selected_p, config->selected_p,
+                        config->field->stage);
+        events->score += CLEAR_FIELD_MATCH;
+    }
+
+    return res;
+}
+
+int apply_game_command(struct game_config *config, const game_command *command, game_events *events) {
+    int res, move;
+
+    events->count = 0;
+    events->score = 0;
+
+    /* a move is recorded as one step of the journal; a new stage, an undo
+     * and a redo replace or replay moves and are not recorded */
+    move = command->type == GAME_COMMAND_SELECT || command->type == GAME_COMMAND_EXPAND ||
+        command->type == GAME_COMMAND_HINT || command->type == GAME_COMMAND_HINT_PAIR;
+
+    if (move)
+        begin_field_journal_move(config->field);
+
+    switch (command->type) {
+    case GAME_COMMAND_SELECT:
+        res = select_game_engine_cell(config, command->pos, events);
+        break;
+    case GAME_COMMAND_EXPAND:
+        res = expand_game_engine_field(config, events);
+        break;
+    case GAME_COMMAND_HINT:
+        res = show_game_engine_hint(config, NULL, events);
+        break;
+    case GAME_COMMAND_HINT_PAIR:
+        res = show_game_engine_hint(config, command, events);
+        break;
+    case GAME_COMMAND_NEW_STAGE:
+        res = start_game_engine_stage(config, events);
+        break;
+    case GAME_COMMAND_UNDO:
+        res = replay_game_engine_move(config, 1, events);
+        break;
+    case GAME_COMMAND_REDO:
+        res = replay_game_engine_move(config, 0, events);
+        break;
+    default:
+        res = 0;
+        break;
+    }
+
+    if (move)
+        end_field_journal_move(config->field);
+
+    if (res && config->replay.recording)
+        record_game_replay_command(&config->replay, command, events, config->field);
+
+    if (res && check_game_field_is_clear(config->field))
+        push_game_event(events, GAME_EVENT_FIELD_CLEARED, config->selected_p, config->selected_p, 0);
+    else if (res && check_game_is_over(config->field))
+        push_game_event(events, GAME_EVENT_GAME_OVER, config->selected_p, config->selected_p, 0);
+
+    return res;
+}
+
+const game_event* find_game_event(const game_events *events, GAME_EVENT_TYPE type) {
+    const game_event *res;
+    int i;
+
+    res = NULL;
+    for (i = 0; i < events->count && res == NULL; i++) {
+        if (events->items[i].type == type)
+            res = events->items + i;
+    }
+
+    return res;
+}
+
+int count_game_events(const game_events *events, GAME_EVENT_TYPE type) {
+    int res, i;
+
+    res = 0;
+    for (i = 0; i < events->count; i++) {
+        if (events->items[i].type == type)
+            res++;
+    }
+
+    return res;
+}
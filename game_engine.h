@@ -0,0 +1,154 @@
+/**
+ * @file game_engine.h
+ * @brief Rules of NumberMatch as commands and events, without any I/O.
+ *
+ * A front end turns the player's input into a game_command and passes it to
+ * apply_game_command(), which changes the game state and reports what
+ * happened as game_event values: a selection, a played pair and its points,
+ * the rows removed, the cells added, a hint, a new stage, the end of the
+ * game. The engine never displays anything and never writes a file: showing
+ * the events and saving the game are left to the caller, so that headless
+ * drivers run the rules at memory speed.
+ *
+ * The state lives in the game_config: the field, the selected cell, the hint
+ * budget, the board of the next stage and the replay being recorded. The output strategy of the
+ * configuration is not used.
+ */
+
+#ifndef GAME_ENGINE_H
+#define GAME_ENGINE_H
+
+#include"game_config.h"
+
+/**
+ * @brief Largest number of events a command reports.
+ */
+#define GAME_EVENTS_MAX 8
+
+/**
+ * @brief Actions of the player.
+ */
+enum GAME_COMMAND_TYPE {
+    GAME_COMMAND_SELECT = 0,    /**< Select a cell, or play it with the selected one. */
+    GAME_COMMAND_EXPAND = 1,    /**< Append the values of the available cells. */
+    GAME_COMMAND_HINT = 2,      /**< Highlight a pair. */
+    GAME_COMMAND_NEW_STAGE = 3, /**< Replace a cleared field with the next stage. */
+    GAME_COMMAND_UNDO = 4,      /**< Undo the last move. */
+    GAME_COMMAND_REDO = 5,      /**< Play again the last undone move. */
+    GAME_COMMAND_HINT_PAIR = 6  /**< Highlight a given pair as a hint, as a recorded hint showed it; the pair must match. */
+};
+
+typedef enum GAME_COMMAND_TYPE GAME_COMMAND_TYPE;
+
+/**
+ * @brief A command passed to the engine.
+ */
+struct game_command {
+    GAME_COMMAND_TYPE type;     /**< Action. */
+    vector2i pos;               /**< Cell of GAME_COMMAND_SELECT, first cell of GAME_COMMAND_HINT_PAIR; ignored otherwise. */
+    vector2i end;               /**< Second cell of GAME_COMMAND_HINT_PAIR; ignored otherwise. */
+};
+
+typedef struct game_command game_command;
+
+/**
+ * @brief What a command did.
+ */
+enum GAME_EVENT_TYPE {
+    GAME_EVENT_SELECTED = 0,            /**< @c start was selected. */
+    GAME_EVENT_UNSELECTED = 1,          /**< The selection of @c start was cancelled. */
+    GAME_EVENT_MATCHED = 2,             /**< The pair @c start, @c end was played for @c value points. */
+    GAME_EVENT_ROW_REMOVED = 3,         /**< Row @c value was removed; later rows moved up. */
+    GAME_EVENT_CELLS_ADDED = 4,         /**< @c value cells were appended. */
+    GAME_EVENT_HINT = 5,                /**< The pair @c start, @c end was highlighted. */
+    GAME_EVENT_NO_ADDITIONS = 6,        /**< No addition is left. */
+    GAME_EVENT_NO_HINTS = 7,            /**< No hint is left. */
+    GAME_EVENT_NO_MATCH = 8,            /**< A hint found no pair, or the pair of a GAME_COMMAND_HINT_PAIR does not match. */
+    GAME_EVENT_UNDONE = 9,              /**< A move was undone. */
+    GAME_EVENT_REDONE = 10,             /**< A move was played again. */
+    GAME_EVENT_NOTHING_TO_UNDO = 11,    /**< No move can be undone. */
+    GAME_EVENT_NOTHING_TO_REDO = 12,    /**< No move can be played again. */
+    GAME_EVENT_FIELD_CLEARED = 13,      /**< No available cell is left. */
+    GAME_EVENT_STAGE_STARTED = 14,      /**< Stage @c value started. */
+    GAME_EVENT_GAME_OVER = 15           /**< No pair and no addition is left. */
+};
+
+typedef enum GAME_EVENT_TYPE GAME_EVENT_TYPE;
+
+/**
+ * @brief One event; the meaning of the members depends on the type.
+ */
+struct game_event {
+    GAME_EVENT_TYPE type;       /**< Kind of event. */
+    vector2i start;             /**< First cell, if any. */
+    vector2i end;               /**< Second cell, if any. */
+    int value;                  /**< Points, row, number of cells or stage. */
+};
+
+typedef struct game_event game_event;
+
+/**
+ * @brief Events of a command, in the order they happened.
+ */
+struct game_events {
+    game_event items[GAME_EVENTS_MAX];  /**< Events. */
+    int count;                          /**< Number of events. */
+    int score;                          /**< Points earned by the command. */
+};
+
+typedef struct game_events game_events;
+
+/**
+ * @brief Creates a command.
+ *
+ * @param[in] type Action.
+ * @param[in] pos  Cell of a GAME_COMMAND_SELECT.
+ *
+ * @return The command, whose second cell is @p pos.
+ */
+game_command create_game_command(GAME_COMMAND_TYPE type, vector2i pos);
+
+/**
+ * @brief Applies a command to the game.
+ *
+ * @param[in,out] config  Pointer to the game_config holding the game state.
+ * @param[in]     command Pointer to the command.
+ * @param[out]    events  Pointer receiving the events of the command.
+ *
+ * @return int 1 if the command changed the game, 0 if it was refused.
+ *
+ * @details
+ * - GAME_COMMAND_SELECT on a cell outside the field is refused without event.
+ * - GAME_COMMAND_NEW_STAGE is refused while the field is not cleared, or if
+ *   no board is built by @p config->next_stage. It only swaps the field: the
+ *   caller attaches its journal and its save to the new field and starts
+ *   building the board of the following stage (see start_game_stage()).
+ * - The moves are recorded in the journal of the field, if it has one.
+ * - The accepted commands are recorded in the replay of the configuration,
+ *   if it is recording (see game_replay.h).
+ * - An accepted command ends with GAME_EVENT_FIELD_CLEARED or
+ *   GAME_EVENT_GAME_OVER when the stage or the game is over.
+ */
+int apply_game_command(struct game_config *config, const game_command *command, game_events *events);
+
+/**
+ * @brief Finds the first event of a type.
+ *
+ * @param[in] events Pointer to the events of a command.
+ * @param[in] type   Type looked for.
+ *
+ * @return const game_event* Pointer to the event, or NULL if there is none.
+ */
+const game_event* find_game_event(const game_events *events, GAME_EVENT_TYPE type);
+
+/**
+ * @brief Counts the events of a type.
+ *
+ * @param[in] events Pointer to the events of a command.
+ * @param[in] type   Type counted.
+ *
+ * @return int Number of events of that type.
+ */
+int count_game_events(const game_events *events, GAME_EVENT_TYPE type);
+
+#endif /* GAME_ENGINE_H */
@@ -0,0 +1,193 @@
+#include<string.h>
+
+#include"field_bitboard.h"
+
+/* classes, available, cells, three column masks and seven scratch bitsets */
+#define BITSETS_COUNT 17
+
+#define WORD_INDEX(i) ((size_t) (i) / BITBOARD_WORD_BITS)
+#define WORD_BIT(i) (1UL << ((i) % BITBOARD_WORD_BITS))
+
+
+int count_bitboard_word_bits(unsigned long word) {
+    int res;
+
+#ifdef __GNUC__
+    res = __builtin_popcountl(word);
+#else
+    for (res = 0; word != 0; res++) {
+        word &= word - 1;
+    }
+#endif
+
+    return res;
+}
+
+int get_bitboard_word_lowest_bit(unsigned long word) {
+    int res;
+
+#ifdef __GNUC__
+    res = __builtin_ctzl(word);
+#else
+    for (res = 0; (word & 1) == 0; res++) {
+        word >>= 1;
+    }
+#endif
+
+    return res;
+}
+
+field_bitboard* create_field_bitboard(game_field *field) {
+    field_bitboard *res;
+    unsigned long *bits;
+    size_t j;
+    int i, x;
+
+    res = (field_bitboard*) malloc(sizeof(field_bitboard));
+
+    res->count = (int) field->table->count;
+    res->width = field->width;
+    res->words = WORD_INDEX(res->count + BITBOARD_WORD_BITS - 1);
+    if (res->words == 0)
+        res->words = 1;
+
+    bits = (unsigned long*) calloc(res->words * BITSETS_COUNT, sizeof(unsigned long));
+
+    for (i = 0; i < 5; i++) {
+        res->classes[i] = bits + res->words * i;
+    }
+    res->available = bits + res->words * 5;
+    res->cells = bits + res->words * 6;
+    res->inner_columns = bits + res->words * 7;
+    res->not_first_column = bits + res->words * 8;
+    res->not_last_column = bits + res->words * 9;
+    res->scratch = bits + res->words * 10;
+
+    /* each class is extracted from the cell bytes in a single scan */
+    for (i = 0; i < 5; i++) {
+        find_field_cells_class(field->table->items, res->count, i + 1, res->classes[i]);
+
+        for (j = 0; j < res->words; j++) {
+            res->available[j] |= res->classes[i][j];
+        }
+    }
+
+    for (i = 0; i < res->count; i++) {
+        res->cells[WORD_INDEX(i)] |= WORD_BIT(i);
+
+        x = i % res->width;
+        if (x != 0)
+            res->not_first_column[WORD_INDEX(i)] |= WORD_BIT(i);
+        if (x != res->width - 1)
+            res->not_last_column[WORD_INDEX(i)] |= WORD_BIT(i);
+        if (x != 0 && x != res->width - 1)
+            res->inner_columns[WORD_INDEX(i)] |= WORD_BIT(i);
+    }
+
+    return res;
+}
+
+void free_field_bitboard(field_bitboard *board) {
+    free(board->classes[0]);
+    free(board);
+}
+
+/**
+ * @brief dst = src shifted by @p k cells towards the start of the field.
+ *
+ * @p dst and @p src may be the same bitset.
+ */
+static void shift_bitset_back(unsigned long *dst, const unsigned long *src, size_t words, int k) {
+    size_t i, offset;
+    int bit;
+
+    offset = WORD_INDEX(k);
+    bit = k % BITBOARD_WORD_BITS;
+
+    for (i = 0; i < words; i++) {
+        if (i + offset < words) {
+            dst[i] = src[i + offset] >> bit;
+
+            if (bit != 0 && i + offset + 1 < words)
+                dst[i] |= src[i + offset + 1] << (BITBOARD_WORD_BITS - bit);
+        } else {
+            dst[i] = 0;
+        }
+    }
+}
+
+void get_field_bitboard_starts(field_bitboard *board, MATCH_DIRECTION direction,
+                               unsigned long *starts) {
+    unsigned long *fills[5], *dead, *tmp, *through, *start_mask, any;
+    size_t i, words;
+    int v, step, shift;
+
+    words = board->words;
+    for (v = 0; v < 5; v++) {
+        fills[v] = board->scratch + words * v;
+    }
+    dead = board->scratch + words * 5;
+    tmp = board->scratch + words * 6;
+
+    switch (direction) {
+    case COLUMN_MATCH_DIRECTION:
+        step = board->width;
+        through = board->cells;
+        start_mask = board->cells;
+        break;
+    case LEFT_DIAGONAL_MATCH_DIRECTION:
+        step = board->width - 1;
+        through = board->inner_columns;
+        start_mask = board->not_first_column;
+        break;
+    case RIGHT_DIAGONAL_MATCH_DIRECTION:
+        step = board->width + 1;
+        through = board->inner_columns;
+        start_mask = board->not_last_column;
+        break;
+    default:
+        step = 1;
+        through = board->cells;
+        start_mask = board->cells;
+        break;
+    }
+
+    /* fills[v - 1] starts as the class {v, 10 - v} */
+    for (i = 0; i < words; i++) {
+        for (v = 1; v <= 5; v++) {
+            fills[v - 1][i] = board->classes[v - 1][i];
+        }
+        dead[i] = through[i] & ~board->available[i];
+    }
+
+    /* occluded fill: extend every class backwards through runs of
+       crossed-out cells, doubling the run length covered at each round */
+    shift = step;
+    any = 1;
+    while (any != 0 && shift < board->count) {
+        for (v = 0; v < 5; v++) {
+            shift_bitset_back(tmp, fills[v], words, shift);
+            for (i = 0; i < words; i++) {
+                fills[v][i] |= dead[i] & tmp[i];
+            }
+        }
+
+        shift_bitset_back(tmp, dead, words, shift);
+        any = 0;
+        for (i = 0; i < words; i++) {
+            dead[i] &= tmp[i];
+            any |= dead[i];
+        }
+
+        shift *= 2;
+    }
+
+    /* a cell starts a pair if one step ahead lies its own class' fill */
+    memset(starts, 0, words * sizeof(unsigned long));
+    for (v = 1; v <= 5; v++) {
+        shift_bitset_back(tmp, fills[v - 1], words, step);
+        for (i = 0; i < words; i++) {
+            starts[i] |= tmp[i] & start_mask[i] & board->classes[v - 1][i];
+        }
+    }
+}
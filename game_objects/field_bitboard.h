@@ -0,0 +1,84 @@
+/**
+ * @file field_bitboard.h
+ * @brief Bitboard view of a NumberMatch game field.
+ *
+ * The field is described by one bitset per class of values {v, 10 - v}
+ * plus an availability mask, all laid out in reading order: bit @c i of a bitset is the cell of
+ * index @c i in the field table.
+ *
+ * Pairs are detected with shifts, ANDs and ORs over whole machine words:
+ * a direction is a constant shift in reading order (1 for the next cell,
+ * width for the column, width ± 1 for the diagonals), crossed-out cells are
+ * jumped over with an occluded fill, and two cells match when they belong to
+ * the same class {v, 10 - v}.
+ */
+
+#ifndef FIELD_BITBOARD_H
+#define FIELD_BITBOARD_H
+
+#include"game_field.h"
+#include"match_index.h"
+
+/**
+ * @brief Number of cells described by one word of a bitset.
+ */
+#define BITBOARD_WORD_BITS ((int) (sizeof(unsigned long) * 8))
+
+/**
+ * @brief Bitboard representation of a game field.
+ */
+struct field_bitboard {
+    unsigned long *classes[5];      /**< classes[v - 1]: available cells holding v or 10 - v. */
+    unsigned long *available;       /**< Available cells. */
+    unsigned long *cells;           /**< Every cell of the field (first @c count bits). */
+    unsigned long *inner_columns;   /**< Cells neither in the first nor in the last column. */
+    unsigned long *not_first_column;/**< Cells outside the first column. */
+    unsigned long *not_last_column; /**< Cells outside the last column. */
+    unsigned long *scratch;         /**< Work space for the fills. */
+    size_t words;                   /**< Number of words of each bitset. */
+    int count;                      /**< Number of cells described. */
+    int width;                      /**< Width of the field. */
+};
+
+typedef struct field_bitboard field_bitboard;
+
+/**
+ * @brief Builds the bitboard view of a field.
+ *
+ * @param[in] field Pointer to the game_field to describe.
+ *
+ * @return Pointer to a newly allocated field_bitboard.
+ */
+field_bitboard* create_field_bitboard(game_field *field);
+
+/**
+ * @brief Frees a bitboard created by create_field_bitboard().
+ *
+ * @param[in] board Pointer to the bitboard to free.
+ */
+void free_field_bitboard(field_bitboard *board);
+
+/**
+ * @brief Computes the cells that start a valid pair in a direction.
+ *
+ * Bit @c i of @p starts is set if the first available cell after cell @c i
+ * in @p direction forms a valid pair with it.
+ *
+ * @param[in,out] board     Pointer to the bitboard.
+ * @param[in]     direction Direction of the pairs.
+ * @param[out]    starts    Bitset of @c board->words words receiving the result.
+ */
+void get_field_bitboard_starts(field_bitboard *board, MATCH_DIRECTION direction,
+                               unsigned long *starts);
+
+/**
+ * @brief Returns the number of bits set in a word.
+ */
+int count_bitboard_word_bits(unsigned long word);
+
+/**
+ * @brief Returns the index of the lowest bit set in a non-zero word.
+ */
+int get_bitboard_word_lowest_bit(unsigned long word);
+
+#endif /* FIELD_BITBOARD_H */
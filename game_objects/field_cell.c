@@ -1,31 +1,89 @@
 #include<stdio.h>
+#include<string.h>
 
 #include"field_cell.h"
 
+#ifdef __SSE2__
+#include<emmintrin.h>
+#endif
+
+/* availability flag repeated in every byte of a machine word */
+#define AVAILABLE_WORD_MASK ((unsigned long) -1 / 255 * FIELD_CELL_AVAILABLE)
+
+#define MASK_WORD_BITS (sizeof(unsigned long) * 8)
+
 
 field_cell create_field_cell(short value) {
-    field_cell res;
-    
-    res.value = value;
-    res.is_available = 1;
-    res.is_selected = 0;
-    res.is_highlited = 0;
-    res.is_cursor = 0;
-    
-    return res;
+    return (field_cell) (FIELD_CELL_VALUE(value) | FIELD_CELL_AVAILABLE);
 }
 
 int check_field_cell_math(field_cell *a, field_cell *b) {
-    int res;
+    int res, a_value, b_value;
 
     if (a == NULL || b == NULL || a == b ||
-        !a->is_available || !b->is_available) {
+        !FIELD_CELL_IS_AVAILABLE(*a) || !FIELD_CELL_IS_AVAILABLE(*b)) {
         res = 0;
-    } else if (a->value == b->value || a->value + b->value == 10) {
-        res = 1;
     } else {
-        res = 0;
+        a_value = FIELD_CELL_VALUE(*a);
+        b_value = FIELD_CELL_VALUE(*b);
+
+        if (a_value == b_value || a_value + b_value == 10) {
+            res = 1;
+        } else {
+            res = 0;
+        }
     }
 
     return res;
-}
\ No newline at end of file
+}
+
+int check_field_cells_available(const field_cell *cells, size_t count) {
+    unsigned long word, acc;
+    size_t i;
+
+    acc = 0;
+    for (i = 0; acc == 0 && i + sizeof(unsigned long) <= count; i += sizeof(unsigned long)) {
+        memcpy(&word, cells + i, sizeof(unsigned long));
+        acc = word & AVAILABLE_WORD_MASK;
+    }
+
+    for (; acc == 0 && i < count; i++) {
+        acc = FIELD_CELL_IS_AVAILABLE(cells[i]);
+    }
+
+    return acc != 0;
+}
+
+void find_field_cells_class(const field_cell *cells, size_t count, short value, unsigned long *mask) {
+    field_cell key, complement;
+    size_t i;
+#ifdef __SSE2__
+    __m128i bytes, keys, complements, flags;
+#endif
+
+    /* a cell matches when its value and availability bits equal a key */
+    key = create_field_cell(value);
+    complement = create_field_cell(10 - value);
+
+    memset(mask, 0, (count + MASK_WORD_BITS - 1) / MASK_WORD_BITS * sizeof(unsigned long));
+
+    i = 0;
+#ifdef __SSE2__
+    keys = _mm_set1_epi8((char) key);
+    complements = _mm_set1_epi8((char) complement);
+    flags = _mm_set1_epi8((char) (FIELD_CELL_VALUE_MASK | FIELD_CELL_AVAILABLE));
+
+    for (; i + 16 <= count; i += 16) {
+        bytes = _mm_and_si128(_mm_loadu_si128((const __m128i*) (cells + i)), flags);
+        bytes = _mm_or_si128(_mm_cmpeq_epi8(bytes, keys), _mm_cmpeq_epi8(bytes, complements));
+
+        mask[i / MASK_WORD_BITS] |= (unsigned long) _mm_movemask_epi8(bytes) << (i % MASK_WORD_BITS);
+    }
+#endif
+
+    for (; i < count; i++) {
+        if ((field_cell) (cells[i] & (FIELD_CELL_VALUE_MASK | FIELD_CELL_AVAILABLE)) == key ||
+            (field_cell) (cells[i] & (FIELD_CELL_VALUE_MASK | FIELD_CELL_AVAILABLE)) == complement)
+            mask[i / MASK_WORD_BITS] |= 1UL << (i % MASK_WORD_BITS);
+    }
+}
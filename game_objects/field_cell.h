@@ -2,38 +2,79 @@
  * @file field_cell.h
  * @brief Defines the structure and operations for a single game field cell.
  *
- * This header provides the @ref field_cell structure along with helper
- * functions used to create and validate cells in the NumberMatch-style game.
+ * This header provides the @ref field_cell type along with helper
+ * macros and functions used to create, read and validate cells in the
+ * NumberMatch-style game.
  *
  */
 
 #ifndef FIELD_CELL_H
 #define FIELD_CELL_H
 
+#include<stddef.h>
 
 /**
- * @brief Represents a single cell in the game field.
+ * @brief Represents a single cell in the game field, packed into one byte.
  *
- * Each cell stores a numeric value and several state flags that determine
- * how it should be displayed and whether the player can interact with it.
+ * Layout of the byte (the same one used by the save file):
+ * - bits 0–3 — numeric value of the cell (1–9),
+ * - bit 4    — the cursor is pointing to this cell,
+ * - bit 5    — the cell is currently selected by the player,
+ * - bit 6    — the cell is visually highlighted,
+ * - bit 7    — the cell is active and can be used.
+ *
+ * Cells must be read and written through the FIELD_CELL_* macros below.
  */
-typedef struct  {
-    short value;        /**< Numeric value of the cell (1–9). */
-    int is_available;   /**< 1 if the cell is active and can be used; 0 otherwise. */
-    int is_selected;    /**< 1 if the cell is currently selected by the player. */
-    int is_highlited;   /**< 1 if the cell is visually highlighted. */
-    int is_cursor;      /**< 1 if the cursor is currently pointing to this cell. */
-} field_cell;
+typedef unsigned char field_cell;
+
+/** @name Field cell bit layout */
+/** @{ */
+#define FIELD_CELL_VALUE_MASK 15   /**< Bits holding the numeric value. */
+#define FIELD_CELL_CURSOR     16   /**< Cursor flag. */
+#define FIELD_CELL_SELECTED   32   /**< Selection flag. */
+#define FIELD_CELL_HIGHLITED  64   /**< Highlight flag. */
+#define FIELD_CELL_AVAILABLE  128  /**< Availability flag. */
+/** @} */
+
+/** @name Field cell accessors */
+/** @{ */
+
+/** @def FIELD_CELL_VALUE(cell)
+ *  @brief Numeric value (1–9) stored in the cell. */
+#define FIELD_CELL_VALUE(cell) ((cell) & FIELD_CELL_VALUE_MASK)
+
+/** @def FIELD_CELL_IS_AVAILABLE(cell)
+ *  @brief 1 if the cell is active and can be used; 0 otherwise. */
+#define FIELD_CELL_IS_AVAILABLE(cell) (((cell) & FIELD_CELL_AVAILABLE) != 0)
+
+/** @def FIELD_CELL_IS_SELECTED(cell)
+ *  @brief 1 if the cell is currently selected by the player. */
+#define FIELD_CELL_IS_SELECTED(cell) (((cell) & FIELD_CELL_SELECTED) != 0)
+
+/** @def FIELD_CELL_IS_HIGHLITED(cell)
+ *  @brief 1 if the cell is visually highlighted. */
+#define FIELD_CELL_IS_HIGHLITED(cell) (((cell) & FIELD_CELL_HIGHLITED) != 0)
+
+/** @def FIELD_CELL_IS_CURSOR(cell)
+ *  @brief 1 if the cursor is currently pointing to this cell. */
+#define FIELD_CELL_IS_CURSOR(cell) (((cell) & FIELD_CELL_CURSOR) != 0)
+
+/** @def FIELD_CELL_SET_FLAG(cell, flag, value)
+ *  @brief Returns @p cell with @p flag set if @p value is non-zero, cleared otherwise. */
+#define FIELD_CELL_SET_FLAG(cell, flag, value) \
+    ((field_cell) ((value) ? ((cell) | (flag)) : ((cell) & ~(flag))))
+
+/** @} */
 
 /**
  * @brief Creates and initializes a new field cell.
  *
  * @param value Numeric value to assign to the cell (1–9).
  *
- * @return A field_cell structure initialized with:
+ * @return A field_cell initialized with:
  *         - the given value,
- *         - is_available set to 1,
- *         - is_selected, is_highlited and is_cursor set to 0.
+ *         - the availability flag set,
+ *         - the selection, highlight and cursor flags cleared.
  */
 field_cell create_field_cell(short value);
 
@@ -45,12 +86,42 @@ field_cell create_field_cell(short value);
  * - Both cells are marked as available.
  * - The two pointers refer to different cells.
  *
- * @param a Pointer to the first field_cell structure.
- * @param b Pointer to the second field_cell structure.
+ * @param a Pointer to the first field_cell.
+ * @param b Pointer to the second field_cell.
  *
  * @return 1 if the cells form a valid match,  
  *         0 otherwise.
  */
 int check_field_cell_math(field_cell *a, field_cell *b);
 
-#endif
\ No newline at end of file
+/**
+ * @brief Checks whether any cell of a contiguous run is available.
+ *
+ * The availability flags are tested a machine word at a time, so a whole
+ * row is usually checked with one or two operations.
+ *
+ * @param cells Pointer to the first cell of the run.
+ * @param count Number of cells in the run.
+ *
+ * @return 1 if at least one cell is available, 0 otherwise.
+ */
+int check_field_cells_available(const field_cell *cells, size_t count);
+
+/**
+ * @brief Finds the available cells of a run that can be paired with a value.
+ *
+ * Marks in one pass every available cell holding @p value or 10 - @p value.
+ * Bit @c i of the result (bit <tt>i % (8 * sizeof(unsigned long))</tt> of
+ * word <tt>i / (8 * sizeof(unsigned long))</tt>) describes cell @c i.
+ * Sixteen cells are compared at once with SSE2 when the compiler targets it,
+ * one at a time otherwise.
+ *
+ * @param cells Pointer to the first cell of the run.
+ * @param count Number of cells in the run.
+ * @param value Value of the class (1–9).
+ * @param mask  Output bitset of at least @p count bits; every word it covers
+ *              is overwritten.
+ */
+void find_field_cells_class(const field_cell *cells, size_t count, short value, unsigned long *mask);
+
+#endif
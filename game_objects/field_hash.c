@@ -0,0 +1,169 @@
+#include"field_hash.h"
+
+#define VECTOR_TYPE unsigned long
+#define VECTOR_NAME row_hash_table
+#define VECTOR_STRUCT_DEFINED
+#include "vector.h"
+
+/* a 64-bit constant that still compiles, truncated, where long has 32 bits */
+#define HASH_CONSTANT(high, low) (((unsigned long) (high) << 16 << 16) | (unsigned long) (low))
+
+/* fractional part of the golden ratio, spreads the row indices */
+#define HASH_GOLDEN HASH_CONSTANT(0x9E3779B9UL, 0x7F4A7C15UL)
+
+/* bits of a cell that take part in the hash */
+#define HASH_CELL_MASK (FIELD_CELL_VALUE_MASK | FIELD_CELL_AVAILABLE)
+
+
+unsigned long mix_field_hash_word(unsigned long value) {
+    value = (value ^ (value >> 30)) * HASH_CONSTANT(0xBF58476DUL, 0x1CE4E5B9UL);
+    value = (value ^ (value >> 27)) * HASH_CONSTANT(0x94D049BBUL, 0x133111EBUL);
+
+    return value ^ (value >> 31);
+}
+
+static unsigned long get_cell_key(int x, field_cell cell) {
+    return mix_field_hash_word(((unsigned long) x << 8 | (cell & HASH_CELL_MASK)) + HASH_GOLDEN);
+}
+
+/**
+ * @brief Contribution of a row to the field hash, depending on its position.
+ */
+static unsigned long get_row_key(unsigned long row_hash, int row) {
+    return mix_field_hash_word(row_hash + (unsigned long) (row + 1) * HASH_GOLDEN);
+}
+
+void init_field_hash(game_field *field) {
+    field->row_hashes = row_hash_table_create(0);
+    field->hash = 0;
+}
+
+void free_field_hash(game_field *field) {
+    row_hash_table_free(field->row_hashes);
+}
+
+void copy_field_hash(game_field *field, game_field *source) {
+    field->row_hashes = row_hash_table_copy(source->row_hashes);
+}
+
+void clear_field_hash(game_field *field) {
+    row_hash_table_clear(field->row_hashes);
+    field->hash = 0;
+}
+
+void update_field_hash_cell(game_field *field, int index, field_cell previous) {
+    unsigned long *rows;
+    int row, x;
+
+    rows = field->row_hashes->items;
+    row = index / field->width;
+    x = index % field->width;
+
+    field->hash ^= get_row_key(rows[row], row);
+    rows[row] ^= get_cell_key(x, previous) ^ get_cell_key(x, field->table->items[index]);
+    field->hash ^= get_row_key(rows[row], row);
+}
+
+void update_field_hash_appended(game_field *field, int first) {
+    unsigned long *rows;
+    int i, y, count, height, old_height;
+
+    count = (int) field->table->count;
+    height = get_game_field_height(field);
+    old_height = (int) field->row_hashes->count;
+
+    row_hash_table_reserve(field->row_hashes, height);
+    field->row_hashes->count = height;
+    rows = field->row_hashes->items;
+
+    /* the last row may have been partial: its old contribution goes away */
+    for (y = first / field->width; y < old_height; y++) {
+        field->hash ^= get_row_key(rows[y], y);
+    }
+    for (y = old_height; y < height; y++) {
+        rows[y] = 0;
+    }
+
+    for (i = first; i < count; i++) {
+        rows[i / field->width] ^= get_cell_key(i % field->width, field->table->items[i]);
+    }
+
+    for (y = first / field->width; y < height; y++) {
+        field->hash ^= get_row_key(rows[y], y);
+    }
+}
+
+void update_field_hash_inserted_row(game_field *field, int index) {
+    unsigned long *rows, row;
+    int i, y, start, end, height;
+
+    rows = field->row_hashes->items;
+    height = (int) field->row_hashes->count;
+
+    for (y = index; y < height; y++) {
+        field->hash ^= get_row_key(rows[y], y);
+    }
+
+    start = index * field->width;
+    end = start + field->width < (int) field->table->count ? start + field->width : (int) field->table->count;
+
+    row = 0;
+    for (i = start; i < end; i++) {
+        row ^= get_cell_key(i - start, field->table->items[i]);
+    }
+
+    row_hash_table_insert(field->row_hashes, row, index);
+    rows = field->row_hashes->items;
+    height++;
+
+    /* the rows below moved down by one */
+    for (y = index; y < height; y++) {
+        field->hash ^= get_row_key(rows[y], y);
+    }
+}
+
+void update_field_hash_truncated(game_field *field, int first) {
+    unsigned long *rows;
+    int i, y, height;
+
+    rows = field->row_hashes->items;
+    height = (int) field->row_hashes->count;
+
+    for (y = first / field->width; y < height; y++) {
+        field->hash ^= get_row_key(rows[y], y);
+    }
+
+    field->row_hashes->count = get_game_field_height(field);
+
+    /* the last row kept may now be partial */
+    if (first % field->width != 0) {
+        y = first / field->width;
+        rows[y] = 0;
+
+        for (i = y * field->width; i < first; i++) {
+            rows[y] ^= get_cell_key(i % field->width, field->table->items[i]);
+        }
+
+        field->hash ^= get_row_key(rows[y], y);
+    }
+}
+
+void update_field_hash_removed_row(game_field *field, int index) {
+    unsigned long *rows;
+    int y, height;
+
+    rows = field->row_hashes->items;
+    height = (int) field->row_hashes->count;
+
+    for (y = index; y < height; y++) {
+        field->hash ^= get_row_key(rows[y], y);
+    }
+
+    row_hash_table_remove(field->row_hashes, index);
+    height--;
+
+    /* the rows below moved up by one */
+    for (y = index; y < height; y++) {
+        field->hash ^= get_row_key(rows[y], y);
+    }
+}
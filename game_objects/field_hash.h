@@ -0,0 +1,103 @@
+/**
+ * @file field_hash.h
+ * @brief Incremental Zobrist-style hash of the cells of a game field.
+ *
+ * Each cell contributes a pseudo-random key derived from its column, value
+ * and availability; the keys of a row are XORed into a row hash, and every
+ * row hash is mixed with its row index before being XORed into the field
+ * hash. Two fields with the same width and the same cells (values and
+ * availability, the display flags are ignored) have the same hash, whatever
+ * moves led to them.
+ *
+ * Crossing out a cell updates one row in O(1). Removing a row moves every
+ * row below it up, so their contributions are re-mixed in O(rows), which is
+ * less than the cell buffer move it comes with.
+ *
+ * Hashes are unsigned long: 64 bits on LP64 targets.
+ */
+
+#ifndef FIELD_HASH_H
+#define FIELD_HASH_H
+
+#include"game_field.h"
+
+/**
+ * @brief Scrambles a word, the mixing function behind every key.
+ *
+ * @param[in] value Word to scramble.
+ *
+ * @return The scrambled word.
+ */
+unsigned long mix_field_hash_word(unsigned long value);
+
+/**
+ * @brief Allocates an empty hash for the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void init_field_hash(game_field *field);
+
+/**
+ * @brief Frees the row hashes of the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void free_field_hash(game_field *field);
+
+/**
+ * @brief Gives a copied field its own copy of the row hashes.
+ *
+ * @param[in,out] field  Pointer to the copy, sharing the row hashes of @p source.
+ * @param[in]     source Pointer to the original game_field.
+ */
+void copy_field_hash(game_field *field, game_field *source);
+
+/**
+ * @brief Resets the hash of a field whose cells were all removed.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void clear_field_hash(game_field *field);
+
+/**
+ * @brief Updates the hash after a cell changed.
+ *
+ * @param[in,out] field    Pointer to the game_field.
+ * @param[in]     index    Index of the cell in reading order.
+ * @param[in]     previous Content of the cell before the change.
+ */
+void update_field_hash_cell(game_field *field, int index, field_cell previous);
+
+/**
+ * @brief Updates the hash after cells were appended to the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     first Index of the first appended cell.
+ */
+void update_field_hash_appended(game_field *field, int first);
+
+/**
+ * @brief Updates the hash after a row was inserted.
+ *
+ * @param[in,out] field Pointer to the game_field, already with the row.
+ * @param[in]     index Index of the inserted row.
+ */
+void update_field_hash_inserted_row(game_field *field, int index);
+
+/**
+ * @brief Updates the hash after the cells from an index to the end were removed.
+ *
+ * @param[in,out] field Pointer to the game_field, already without the cells.
+ * @param[in]     first Index of the first removed cell.
+ */
+void update_field_hash_truncated(game_field *field, int first);
+
+/**
+ * @brief Updates the hash after a row was removed.
+ *
+ * @param[in,out] field Pointer to the game_field, already without the row.
+ * @param[in]     index Index of the removed row.
+ */
+void update_field_hash_removed_row(game_field *field, int index);
+
+#endif /* FIELD_HASH_H */
@@ -0,0 +1,296 @@
+#include"field_journal.h"
+
+#define VECTOR_TYPE journal_move
+#define VECTOR_NAME journal_move_table
+#define VECTOR_STRUCT_DEFINED
+#include "vector.h"
+
+#define VECTOR_TYPE journal_entry
+#define VECTOR_NAME journal_entry_table
+#define VECTOR_STRUCT_DEFINED
+#include "vector.h"
+
+#define VECTOR_TYPE field_cell
+#define VECTOR_NAME journal_cell_table
+#define VECTOR_STRUCT_DEFINED
+#include "vector.h"
+
+/* bits of a cell a move can change; the cursor and the selection are not moves */
+#define JOURNAL_CELL_MASK (FIELD_CELL_VALUE_MASK | FIELD_CELL_AVAILABLE | FIELD_CELL_HIGHLITED)
+
+
+field_journal* create_field_journal(long limit) {
+    field_journal *res;
+
+    res = (field_journal*) malloc(sizeof(field_journal));
+
+    res->moves = journal_move_table_create(0);
+    res->entries = journal_entry_table_create(0);
+    res->cells = journal_cell_table_create(0);
+    res->position = 0;
+    res->limit = limit;
+    res->recording = 0;
+
+    return res;
+}
+
+void free_field_journal(field_journal *journal) {
+    if (journal != NULL) {
+        journal_move_table_free(journal->moves);
+        journal_entry_table_free(journal->entries);
+        journal_cell_table_free(journal->cells);
+        free(journal);
+    }
+}
+
+void clear_field_journal(field_journal *journal) {
+    journal_move_table_clear(journal->moves);
+    journal_entry_table_clear(journal->entries);
+    journal_cell_table_clear(journal->cells);
+    journal->position = 0;
+    journal->recording = 0;
+}
+
+static void get_field_journal_counters(game_field *field, journal_move *move, int side) {
+    move->score[side] = field->score;
+    move->additions[side] = field->additions_available;
+    move->hints[side] = field->hints_available;
+}
+
+static void set_field_journal_counters(game_field *field, journal_move *move, int side) {
+    field->score = move->score[side];
+    field->additions_available = move->additions[side];
+    field->hints_available = move->hints[side];
+}
+
+void begin_field_journal_move(game_field *field) {
+    field_journal *journal;
+
+    journal = field->journal;
+
+    if (journal != NULL) {
+        journal->current.first_entry = journal->entries->count;
+        journal->current.first_cell = journal->cells->count;
+        get_field_journal_counters(field, &journal->current, 0);
+        journal->recording = 1;
+    }
+}
+
+/**
+ * @brief Removes the moves in [first, last) from the journal, with their
+ *        entries and cells, and re-bases the moves after them.
+ */
+static void remove_field_journal_moves(field_journal *journal, size_t first, size_t last) {
+    size_t entry_start, entry_end, cell_start, cell_end, i;
+
+    entry_start = journal->moves->items[first].first_entry;
+    cell_start = journal->moves->items[first].first_cell;
+
+    if (last < journal->moves->count) {
+        entry_end = journal->moves->items[last].first_entry;
+        cell_end = journal->moves->items[last].first_cell;
+    } else {
+        entry_end = journal->entries->count;
+        cell_end = journal->cells->count;
+    }
+
+    journal_move_table_remove_range(journal->moves, first, last - first);
+    journal_entry_table_remove_range(journal->entries, entry_start, entry_end - entry_start);
+    journal_cell_table_remove_range(journal->cells, cell_start, cell_end - cell_start);
+
+    for (i = first; i < journal->moves->count; i++) {
+        journal->moves->items[i].first_entry -= entry_end - entry_start;
+        journal->moves->items[i].first_cell -= cell_end - cell_start;
+    }
+    for (i = entry_start; i < journal->entries->count; i++) {
+        journal->entries->items[i].cells -= cell_end - cell_start;
+    }
+}
+
+static long get_field_journal_size(field_journal *journal) {
+    return (long) (journal->moves->count * sizeof(journal_move) +
+                   journal->entries->count * sizeof(journal_entry) +
+                   journal->cells->count * sizeof(field_cell));
+}
+
+void end_field_journal_move(game_field *field) {
+    field_journal *journal;
+    journal_move *move;
+    size_t forgotten;
+
+    journal = field->journal;
+
+    if (journal != NULL && journal->recording) {
+        journal->recording = 0;
+        move = &journal->current;
+        get_field_journal_counters(field, move, 1);
+
+        if (journal->entries->count > move->first_entry ||
+            move->score[0] != move->score[1] ||
+            move->additions[0] != move->additions[1] ||
+            move->hints[0] != move->hints[1]) {
+
+            journal_move_table_push(journal->moves, *move);
+
+            /* the moves that could be redone sit between the played ones and this one */
+            if (journal->position < journal->moves->count - 1)
+                remove_field_journal_moves(journal, journal->position, journal->moves->count - 1);
+            journal->position = journal->moves->count;
+
+            /* the oldest quarter goes, so that forgetting stays cheap on average */
+            if (get_field_journal_size(journal) > journal->limit && journal->moves->count > 1) {
+                forgotten = (journal->moves->count + 3) / 4;
+                remove_field_journal_moves(journal, 0, forgotten);
+                journal->position -= forgotten;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Appends an entry to the move being recorded, storing @p count cells.
+ */
+static void push_field_journal_entry(field_journal *journal, JOURNAL_ENTRY_TYPE type, int index,
+                                     const field_cell *cells, int count) {
+    journal_entry entry;
+    int i;
+
+    entry.type = (unsigned char) type;
+    entry.before = 0;
+    entry.after = 0;
+    entry.index = index;
+    entry.cells = journal->cells->count;
+    entry.count = count;
+
+    journal_cell_table_reserve(journal->cells, journal->cells->count + count);
+    for (i = 0; i < count; i++) {
+        journal->cells->items[journal->cells->count++] = cells[i] & JOURNAL_CELL_MASK;
+    }
+
+    journal_entry_table_push(journal->entries, entry);
+}
+
+void record_field_journal_cell(game_field *field, int index, field_cell before) {
+    field_journal *journal;
+    field_cell after;
+
+    journal = field->journal;
+    after = field->table->items[index];
+
+    if (journal != NULL && journal->recording && ((before ^ after) & JOURNAL_CELL_MASK)) {
+        push_field_journal_entry(journal, JOURNAL_CELL, index, NULL, 0);
+        journal->entries->items[journal->entries->count - 1].before = before & JOURNAL_CELL_MASK;
+        journal->entries->items[journal->entries->count - 1].after = after & JOURNAL_CELL_MASK;
+    }
+}
+
+void record_field_journal_row(game_field *field, int index) {
+    field_journal *journal;
+
+    journal = field->journal;
+
+    if (journal != NULL && journal->recording) {
+        push_field_journal_entry(journal, JOURNAL_ROW_REMOVED, index,
+                                 get_game_field_row(field, index), get_game_field_row_size(field, index));
+    }
+}
+
+void record_field_journal_appended(game_field *field, int first) {
+    field_journal *journal;
+
+    journal = field->journal;
+
+    if (journal != NULL && journal->recording) {
+        push_field_journal_entry(journal, JOURNAL_CELLS_APPENDED, first,
+                                 field->table->items + first, (int) field->table->count - first);
+    }
+}
+
+/**
+ * @brief Gives a cell the flags it had on one side of a change.
+ */
+static void restore_field_journal_cell(game_field *field, int index, field_cell cell) {
+    vector2i pos;
+
+    pos = create_vector2i(index % field->width, index / field->width);
+
+    set_available_game_field_cell(field, pos, FIELD_CELL_IS_AVAILABLE(cell));
+    set_highlight_game_field_cell(field, pos, FIELD_CELL_IS_HIGHLITED(cell));
+}
+
+int undo_field_journal(game_field *field) {
+    field_journal *journal;
+    journal_move *move;
+    journal_entry *entry;
+    size_t i, last;
+    int res;
+
+    journal = field->journal;
+    res = journal != NULL && !journal->recording && journal->position > 0;
+
+    if (res) {
+        journal->position--;
+        move = journal->moves->items + journal->position;
+        last = journal->position + 1 < journal->moves->count ?
+            journal->moves->items[journal->position + 1].first_entry : journal->entries->count;
+
+        for (i = last; i > move->first_entry; i--) {
+            entry = journal->entries->items + i - 1;
+
+            switch (entry->type) {
+            case JOURNAL_CELL:
+                restore_field_journal_cell(field, entry->index, entry->before);
+                break;
+            case JOURNAL_ROW_REMOVED:
+                insert_game_field_row(field, entry->index, journal->cells->items + entry->cells, entry->count);
+                break;
+            case JOURNAL_CELLS_APPENDED:
+                truncate_game_field(field, entry->index);
+                break;
+            }
+        }
+
+        set_field_journal_counters(field, move, 0);
+    }
+
+    return res;
+}
+
+int redo_field_journal(game_field *field) {
+    field_journal *journal;
+    journal_move *move;
+    journal_entry *entry;
+    size_t i, last;
+    int res;
+
+    journal = field->journal;
+    res = journal != NULL && !journal->recording && journal->position < journal->moves->count;
+
+    if (res) {
+        move = journal->moves->items + journal->position;
+        last = journal->position + 1 < journal->moves->count ?
+            journal->moves->items[journal->position + 1].first_entry : journal->entries->count;
+
+        for (i = move->first_entry; i < last; i++) {
+            entry = journal->entries->items + i;
+
+            switch (entry->type) {
+            case JOURNAL_CELL:
+                restore_field_journal_cell(field, entry->index, entry->after);
+                break;
+            case JOURNAL_ROW_REMOVED:
+                remove_game_field_row(field, entry->index);
+                break;
+            case JOURNAL_CELLS_APPENDED:
+                add_cells_game_field(field, journal->cells->items + entry->cells, entry->count);
+                field->count += entry->count;
+                break;
+            }
+        }
+
+        set_field_journal_counters(field, move, 1);
+        journal->position++;
+    }
+
+    return res;
+}
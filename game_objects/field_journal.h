@@ -0,0 +1,202 @@
+/**
+ * @file field_journal.h
+ * @brief Journal of the changes made to a game field, for undo and redo.
+ *
+ * A move (a pair, an addition, a hint) is recorded as the small changes it
+ * made rather than as a copy of the field:
+ * - a cell whose availability or highlight changed, with its old and new value;
+ * - a removed row, with its cells;
+ * - appended cells, with their values;
+ * - the score, additions and hints before and after the move.
+ *
+ * Undoing a move plays its changes backwards, redoing it plays them again,
+ * both through the game_field functions so that the match index, the links
+ * and the hash follow. Restoring a crossed-out cell costs O(1); putting a
+ * row back or removing appended cells re-indexes the field, as removing a
+ * row already moves the cells after it.
+ *
+ * The journal is bounded: when it grows past its limit, the oldest moves
+ * are forgotten.
+ *
+ * Any code can use it as make/unmake: attach a journal to a field, record
+ * a move between begin_field_journal_move() and end_field_journal_move(),
+ * and undo it.
+ */
+
+#ifndef FIELD_JOURNAL_H
+#define FIELD_JOURNAL_H
+
+#include"game_field.h"
+
+/**
+ * @brief Default limit of a journal, in bytes.
+ */
+#define FIELD_JOURNAL_DEFAULT_LIMIT (1L << 20)
+
+/**
+ * @brief Kind of change recorded by an entry.
+ */
+enum JOURNAL_ENTRY_TYPE {
+    JOURNAL_CELL = 0,           /**< A cell changed. */
+    JOURNAL_ROW_REMOVED = 1,    /**< A row was removed. */
+    JOURNAL_CELLS_APPENDED = 2  /**< Cells were appended. */
+};
+
+typedef enum JOURNAL_ENTRY_TYPE JOURNAL_ENTRY_TYPE;
+
+/**
+ * @brief One change of a move.
+ */
+struct journal_entry {
+    unsigned char type;     /**< JOURNAL_ENTRY_TYPE of the change. */
+    field_cell before;      /**< Cell before the change (JOURNAL_CELL). */
+    field_cell after;       /**< Cell after the change (JOURNAL_CELL). */
+    int index;              /**< Index of the cell, of the row, or of the first appended cell. */
+    size_t cells;           /**< Offset of the removed or appended cells in the journal. */
+    int count;              /**< Number of removed or appended cells. */
+};
+
+typedef struct journal_entry journal_entry;
+
+/**
+ * @brief A move: its changes and the counters around it.
+ */
+struct journal_move {
+    size_t first_entry;                 /**< Index of the move's first entry. */
+    size_t first_cell;                  /**< Offset of the move's first stored cell. */
+    int score[2];                       /**< Score before and after the move. */
+    unsigned short additions[2];        /**< Additions available before and after. */
+    unsigned short hints[2];            /**< Hints available before and after. */
+};
+
+typedef struct journal_move journal_move;
+
+/**
+ * @brief Moves of the journal.
+ */
+struct journal_move_table {
+    journal_move* items;
+    size_t count;
+    size_t capacity;
+};
+typedef struct journal_move_table journal_move_table;
+
+/**
+ * @brief Changes of the moves, in order.
+ */
+struct journal_entry_table {
+    journal_entry* items;
+    size_t count;
+    size_t capacity;
+};
+typedef struct journal_entry_table journal_entry_table;
+
+/**
+ * @brief Cells of the removed rows and of the appended cells.
+ */
+struct journal_cell_table {
+    field_cell* items;
+    size_t count;
+    size_t capacity;
+};
+typedef struct journal_cell_table journal_cell_table;
+
+/**
+ * @brief Journal of a field.
+ */
+struct field_journal {
+    journal_move_table *moves;      /**< Recorded moves. */
+    journal_entry_table *entries;   /**< Changes of the moves. */
+    journal_cell_table *cells;      /**< Stored cells. */
+    size_t position;                /**< Number of moves played; the next ones can be redone. */
+    long limit;                     /**< Size in bytes above which old moves are forgotten. */
+    int recording;                  /**< 1 between begin_field_journal_move() and end_field_journal_move(). */
+    journal_move current;           /**< Move being recorded. */
+};
+
+typedef struct field_journal field_journal;
+
+/**
+ * @brief Allocates an empty journal.
+ *
+ * @param[in] limit Size in bytes above which old moves are forgotten.
+ *
+ * @return Pointer to the new journal.
+ */
+field_journal* create_field_journal(long limit);
+
+/**
+ * @brief Frees a journal.
+ *
+ * @param[in] journal Pointer to the journal; NULL is ignored.
+ */
+void free_field_journal(field_journal *journal);
+
+/**
+ * @brief Forgets every move.
+ *
+ * @param[in,out] journal Pointer to the journal.
+ */
+void clear_field_journal(field_journal *journal);
+
+/**
+ * @brief Starts recording a move of the field.
+ *
+ * @param[in,out] field Pointer to the game_field; ignored if it has no journal.
+ */
+void begin_field_journal_move(game_field *field);
+
+/**
+ * @brief Ends the move being recorded.
+ *
+ * A move that changed nothing is dropped. Any recorded move replaces the
+ * moves that could be redone.
+ *
+ * @param[in,out] field Pointer to the game_field; ignored if it has no journal.
+ */
+void end_field_journal_move(game_field *field);
+
+/**
+ * @brief Records a cell change, called by the game_field functions.
+ *
+ * @param[in,out] field  Pointer to the game_field.
+ * @param[in]     index  Index of the cell.
+ * @param[in]     before Cell before the change.
+ */
+void record_field_journal_cell(game_field *field, int index, field_cell before);
+
+/**
+ * @brief Records a row about to be removed, called by the game_field functions.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     index Index of the row, still on the field.
+ */
+void record_field_journal_row(game_field *field, int index);
+
+/**
+ * @brief Records appended cells, called by the game_field functions.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     first Index of the first appended cell.
+ */
+void record_field_journal_appended(game_field *field, int first);
+
+/**
+ * @brief Undoes the last move.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ *
+ * @return 1 if a move was undone, 0 if there is none.
+ */
+int undo_field_journal(game_field *field);
+
+/**
+ * @brief Plays again the last undone move.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ *
+ * @return 1 if a move was redone, 0 if there is none.
+ */
+int redo_field_journal(game_field *field);
+
+#endif /* FIELD_JOURNAL_H */
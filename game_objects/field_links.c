@@ -0,0 +1,244 @@
+#include"field_links.h"
+
+#define VECTOR_TYPE cell_links
+#define VECTOR_NAME links_table
+#define VECTOR_STRUCT_DEFINED
+#include "vector.h"
+
+/* (dx, dy) step of each MATCH_DIRECTION */
+static const int link_directions[MATCH_DIRECTIONS_COUNT][2] = {
+    { 0, 1 }, { -1, 1 }, { 1, 1 }, { 1, 0 }
+};
+
+
+void init_field_links(game_field *field) {
+    field->links = links_table_create(0);
+}
+
+void free_field_links(game_field *field) {
+    links_table_free(field->links);
+}
+
+void copy_field_links(game_field *field, game_field *source) {
+    field->links = links_table_copy(source->links);
+}
+
+void clear_field_links(game_field *field) {
+    links_table_clear(field->links);
+}
+
+int get_next_linked_cell(game_field *field, int index, MATCH_DIRECTION direction) {
+    return field->links->items[index].next[direction];
+}
+
+int get_previous_linked_cell(game_field *field, int index, MATCH_DIRECTION direction) {
+    return field->links->items[index].previous[direction];
+}
+
+/**
+ * @brief Makes two cells adjacent in a direction, -1 standing for the border.
+ */
+static void join_field_cells(game_field *field, int previous, int next, MATCH_DIRECTION direction) {
+    cell_links *links;
+
+    links = field->links->items;
+
+    if (previous != -1)
+        links[previous].next[direction] = next;
+    if (next != -1)
+        links[next].previous[direction] = previous;
+}
+
+void rebuild_field_links(game_field *field) {
+    field_cell *cells;
+    cell_links *links;
+    int i, d, x, count, above, previous;
+
+    count = (int) field->table->count;
+
+    links_table_reserve(field->links, count);
+    field->links->count = count;
+
+    cells = field->table->items;
+    links = field->links->items;
+
+    /* a crossed-out cell temporarily keeps the last available cell before it,
+     * so each cell only looks one step back */
+    x = 0;
+    for (i = 0; i < count; i++) {
+        for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+            above = i - link_directions[d][1] * field->width - link_directions[d][0];
+            previous = -1;
+
+            if (above >= 0 && x - link_directions[d][0] >= 0 && x - link_directions[d][0] < field->width) {
+                previous = FIELD_CELL_IS_AVAILABLE(cells[above]) ? above : links[above].previous[d];
+            } else if (d == NEXT_CELL_MATCH_DIRECTION && i > 0) {
+                previous = FIELD_CELL_IS_AVAILABLE(cells[i - 1]) ? i - 1 : links[i - 1].previous[d];
+            }
+
+            links[i].previous[d] = previous;
+            links[i].next[d] = -1;
+
+            if (FIELD_CELL_IS_AVAILABLE(cells[i]) && previous != -1)
+                links[previous].next[d] = i;
+        }
+
+        if (++x == field->width)
+            x = 0;
+    }
+}
+
+void unlink_field_cell(game_field *field, int index) {
+    cell_links *links;
+    int d;
+
+    links = field->links->items + index;
+
+    for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+        join_field_cells(field, links->previous[d], links->next[d], d);
+    }
+}
+
+void relink_field_cell(game_field *field, int index) {
+    int d, previous, next;
+
+    for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+        previous = get_previous_available_cell(field, index, d);
+
+        /* the cell sits between its previous cell and the former next one */
+        if (previous != -1)
+            next = field->links->items[previous].next[d];
+        else
+            next = get_next_available_cell(field, index, d);
+
+        join_field_cells(field, previous, index, d);
+        join_field_cells(field, index, next, d);
+    }
+}
+
+void update_field_links_appended(game_field *field, int first) {
+    cell_links *links;
+    int i, d, count;
+
+    count = (int) field->table->count;
+
+    /* a field filled from scratch is linked in a single pass */
+    if (first == 0) {
+        rebuild_field_links(field);
+    } else {
+        links_table_reserve(field->links, count);
+        field->links->count = count;
+        links = field->links->items;
+
+        for (i = first; i < count; i++) {
+            for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+                links[i].previous[d] = -1;
+                links[i].next[d] = -1;
+
+                if (FIELD_CELL_IS_AVAILABLE(field->table->items[i]))
+                    join_field_cells(field, get_previous_available_cell(field, i, d), i, d);
+            }
+        }
+    }
+}
+
+void update_field_links_inserted_row(game_field *field, int index) {
+    cell_links *links;
+    int i, d, start, inserted, count, cell;
+
+    start = index * field->width;
+    count = (int) field->table->count;
+    inserted = count - (int) field->links->count;
+
+    links_table_reserve(field->links, count);
+    links = field->links->items;
+    memmove(links + start + inserted, links + start, (field->links->count - start) * sizeof(cell_links));
+    field->links->count = count;
+
+    /* the cells after the row moved forward; columns and the reading order
+     * still link the same cells, the row having no available cell */
+    for (i = 0; i < count; i++) {
+        for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+            if (links[i].next[d] >= start)
+                links[i].next[d] += inserted;
+            if (links[i].previous[d] >= start)
+                links[i].previous[d] += inserted;
+        }
+    }
+
+    for (i = start; i < start + inserted; i++) {
+        for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+            links[i].previous[d] = -1;
+            links[i].next[d] = -1;
+        }
+    }
+
+    /* each diagonal crossing the inserted row now joins other cells */
+    for (i = start; i < start + inserted; i++) {
+        for (d = LEFT_DIAGONAL_MATCH_DIRECTION; d <= RIGHT_DIAGONAL_MATCH_DIRECTION; d++) {
+            cell = get_previous_available_cell(field, i, d);
+            join_field_cells(field, cell, get_next_available_cell(field, i, d), d);
+        }
+    }
+}
+
+void update_field_links_truncated(game_field *field, int first) {
+    cell_links *links;
+    int i, d, count, previous;
+
+    links = field->links->items;
+    count = (int) field->links->count;
+
+    /* the cells before the end lead to the removed cells through the links of these */
+    for (i = first; i < count; i++) {
+        for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+            previous = links[i].previous[d];
+
+            if (previous != -1 && previous < first && links[previous].next[d] >= first)
+                links[previous].next[d] = -1;
+        }
+    }
+
+    field->links->count = first;
+}
+
+void update_field_links_removed_row(game_field *field, int index) {
+    cell_links *links;
+    int i, d, x, start, end, removed, count, previous, cell;
+
+    start = index * field->width;
+    removed = (int) (field->links->count - field->table->count);
+    end = start + removed;
+
+    links_table_remove_range(field->links, start, removed);
+
+    /* the cells after the row moved back; columns and the reading order
+     * still link the same cells */
+    links = field->links->items;
+    count = (int) field->links->count;
+
+    for (i = 0; i < count; i++) {
+        for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+            if (links[i].next[d] >= end)
+                links[i].next[d] -= removed;
+            if (links[i].previous[d] >= end)
+                links[i].previous[d] -= removed;
+        }
+    }
+
+    /* diagonals crossing the removed row now continue one column further */
+    if (index > 0) {
+        for (x = 0; x < field->width; x++) {
+            for (d = LEFT_DIAGONAL_MATCH_DIRECTION; d <= RIGHT_DIAGONAL_MATCH_DIRECTION; d++) {
+                cell = start - field->width + x;
+
+                if (FIELD_CELL_IS_AVAILABLE(field->table->items[cell]))
+                    previous = cell;
+                else
+                    previous = get_previous_available_cell(field, cell, d);
+
+                join_field_cells(field, previous, get_next_available_cell(field, cell, d), d);
+            }
+        }
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * @file field_links.h
+ * @brief Nearest-available-neighbour links between the cells of a game field.
+ *
+ * For every available cell the field keeps the index of the nearest available
+ * cell in the four MATCH_DIRECTION directions and in their reverses, which
+ * covers the eight compass directions (east and west being the reading order
+ * restricted to a line). Crossed-out cells are skipped entirely.
+ *
+ * Crossing out a cell splices it out of its eight lists, like a dancing-links
+ * structure: its neighbours are linked to each other and the cell keeps its
+ * own links, so they still name its former neighbours right after the splice.
+ * Walking a direction, and therefore check_match(), costs O(1) instead of
+ * O(distance).
+ */
+
+#ifndef FIELD_LINKS_H
+#define FIELD_LINKS_H
+
+#include"game_field.h"
+#include"match_index.h"
+
+/**
+ * @brief Allocates empty links for the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void init_field_links(game_field *field);
+
+/**
+ * @brief Frees the links of the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void free_field_links(game_field *field);
+
+/**
+ * @brief Gives a copied field its own copy of the links.
+ *
+ * @param[in,out] field  Pointer to the copy, sharing the links of @p source.
+ * @param[in]     source Pointer to the original game_field.
+ */
+void copy_field_links(game_field *field, game_field *source);
+
+/**
+ * @brief Removes every link, keeping the memory.
+ *
+ * @param[in,out] field Pointer to the game_field whose cells were all removed.
+ */
+void clear_field_links(game_field *field);
+
+/**
+ * @brief Recomputes every link in one pass over the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void rebuild_field_links(game_field *field);
+
+/**
+ * @brief Returns the nearest available cell after a cell in a direction.
+ *
+ * @param[in] field     Pointer to the game_field.
+ * @param[in] index     Index of an available cell, or of a cell that was
+ *                      just crossed out.
+ * @param[in] direction Direction of the link.
+ *
+ * @return Index of the linked cell, or -1 if there is none.
+ */
+int get_next_linked_cell(game_field *field, int index, MATCH_DIRECTION direction);
+
+/**
+ * @brief Returns the nearest available cell before a cell in a direction.
+ *
+ * @param[in] field     Pointer to the game_field.
+ * @param[in] index     Index of an available cell, or of a cell that was
+ *                      just crossed out.
+ * @param[in] direction Direction whose reverse is followed.
+ *
+ * @return Index of the linked cell, or -1 if there is none.
+ */
+int get_previous_linked_cell(game_field *field, int index, MATCH_DIRECTION direction);
+
+/**
+ * @brief Splices a cell that was just crossed out out of its lists.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     index Index of the crossed-out cell.
+ */
+void unlink_field_cell(game_field *field, int index);
+
+/**
+ * @brief Inserts a cell that became available back into its lists.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     index Index of the available cell.
+ */
+void relink_field_cell(game_field *field, int index);
+
+/**
+ * @brief Links cells appended at the end of the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     first Index of the first appended cell.
+ */
+void update_field_links_appended(game_field *field, int first);
+
+/**
+ * @brief Updates the links after a row without available cells was inserted.
+ *
+ * @param[in,out] field Pointer to the game_field, already with the row.
+ * @param[in]     index Index of the inserted row.
+ */
+void update_field_links_inserted_row(game_field *field, int index);
+
+/**
+ * @brief Updates the links before the cells from an index to the end are removed.
+ *
+ * @param[in,out] field Pointer to the game_field, still with the cells.
+ * @param[in]     first Index of the first removed cell.
+ */
+void update_field_links_truncated(game_field *field, int first);
+
+/**
+ * @brief Updates the links after a row without available cells was removed.
+ *
+ * @param[in,out] field Pointer to the game_field, already without the row.
+ * @param[in]     index Index of the removed row.
+ */
+void update_field_links_removed_row(game_field *field, int index);
+
+#endif /* FIELD_LINKS_H */
@@ -0,0 +1,353 @@
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+#include"field_mapping.h"
+
+#define VECTOR_TYPE int
+#define VECTOR_NAME mapping_row_table
+#define VECTOR_STRUCT_DEFINED
+#include "vector.h"
+
+/* bits of a cell kept in the file; the cursor and the selection are not saved */
+#define MAPPING_CELL_MASK (FIELD_CELL_VALUE_MASK | FIELD_CELL_AVAILABLE | FIELD_CELL_HIGHLITED)
+
+/* rows the file gets room for, on top of the rows of the field, when it is written whole */
+#define MAPPING_SPARE_ROWS 16
+
+
+/**
+ * @brief Frees the mapping data and closes the file, without syncing.
+ */
+static void close_field_mapping_file(field_mapping *mapping) {
+    if (mapping->data != NULL)
+        munmap(mapping->data, mapping->size);
+    if (mapping->fd >= 0)
+        close(mapping->fd);
+
+    mapping->data = NULL;
+    mapping->fd = -1;
+    mapping->size = 0;
+}
+
+field_mapping* create_field_mapping(const char *file_name) {
+    field_mapping *res;
+
+    res = (field_mapping*) malloc(sizeof(field_mapping));
+
+    res->file_name = (char*) malloc(strlen(file_name) + 1);
+    strcpy(res->file_name, file_name);
+
+    res->fd = -1;
+    res->data = NULL;
+    res->size = 0;
+    res->width = 0;
+    res->capacity = 0;
+    res->used = 0;
+    res->rows = mapping_row_table_create(0);
+    res->removed = mapping_row_table_create(0);
+
+    return res;
+}
+
+void free_field_mapping(field_mapping *mapping) {
+    if (mapping != NULL) {
+        if (mapping->data != NULL)
+            msync(mapping->data, mapping->size, MS_SYNC);
+
+        close_field_mapping_file(mapping);
+        mapping_row_table_free(mapping->rows);
+        mapping_row_table_free(mapping->removed);
+        free(mapping->file_name);
+        free(mapping);
+    }
+}
+
+/**
+ * @brief Sizes the file for @p capacity rows and maps it again.
+ *
+ * @return 1 on success; on failure the file is closed and the mapping stops.
+ */
+static int resize_field_mapping(field_mapping *mapping, int capacity) {
+    size_t size;
+    int res;
+
+    size = FIELD_MAPPING_HEADER_SIZE + (size_t) capacity * (mapping->width + 1);
+
+    if (mapping->data != NULL)
+        munmap(mapping->data, mapping->size);
+    mapping->data = NULL;
+
+    res = ftruncate(mapping->fd, (off_t) size) == 0;
+
+    if (res) {
+        mapping->data = (unsigned char*) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mapping->fd, 0);
+        res = mapping->data != MAP_FAILED;
+    }
+
+    if (res) {
+        mapping->size = size;
+        mapping->capacity = capacity;
+    } else {
+        printf("Error while serializing game file\nCant map file: %s\n", mapping->file_name);
+        mapping->data = NULL;
+        close_field_mapping_file(mapping);
+    }
+
+    return res;
+}
+
+static unsigned char* get_field_mapping_row(field_mapping *mapping, int row) {
+    return mapping->data + FIELD_MAPPING_HEADER_SIZE + (size_t) row * (mapping->width + 1);
+}
+
+/**
+ * @brief Writes a number of @p bytes bytes, least significant first.
+ */
+static void write_field_mapping_number(unsigned char *data, unsigned long value, int bytes) {
+    int i;
+
+    for (i = 0; i < bytes; i++) {
+        data[i] = (unsigned char) (value >> (8 * i) & 0xFF);
+    }
+}
+
+static unsigned long read_field_mapping_number(const unsigned char *data, int bytes) {
+    unsigned long res;
+    int i;
+
+    res = 0;
+    for (i = 0; i < bytes; i++) {
+        res |= (unsigned long) data[i] << (8 * i);
+    }
+
+    return res;
+}
+
+static void write_field_mapping_header(game_field *field) {
+    unsigned char *data;
+    int i;
+
+    data = field->mapping->data;
+
+    memcpy(data, FIELD_MAPPING_MAGIC, 4);
+    write_field_mapping_number(data + 4, field->width, 2);
+    write_field_mapping_number(data + 6, field->stage, 2);
+    write_field_mapping_number(data + 8, (unsigned long) field->score, 4);
+    write_field_mapping_number(data + 12, (unsigned long) field->table->count, 4);
+    data[16] = (unsigned char) (field->additions_max * 16 + field->additions_available);
+    data[17] = (unsigned char) (field->hints_max * 16 + field->hints_available);
+
+    write_field_mapping_number(data + FIELD_MAPPING_RANDOM, field->random.seed, 4);
+    for (i = 0; i < 4; i++) {
+        write_field_mapping_number(data + FIELD_MAPPING_RANDOM + 4 * (i + 1), field->random.state[i], 4);
+    }
+}
+
+/**
+ * @brief Writes the cells of a row of the field to its row of the file.
+ */
+static void write_field_mapping_row(game_field *field, int row) {
+    unsigned char *data;
+    field_cell *cells;
+    int i, size;
+
+    data = get_field_mapping_row(field->mapping, field->mapping->rows->items[row]);
+    cells = get_game_field_row(field, row);
+    size = get_game_field_row_size(field, row);
+
+    data[0] = 1;
+    for (i = 0; i < size; i++) {
+        data[1 + i] = cells[i] & MAPPING_CELL_MASK;
+    }
+}
+
+int reset_field_mapping(game_field *field) {
+    field_mapping *mapping;
+    char *temp_name;
+    int res, row, height;
+
+    mapping = field->mapping;
+    res = 0;
+
+    if (mapping != NULL) {
+        close_field_mapping_file(mapping);
+        mapping_row_table_clear(mapping->rows);
+        mapping_row_table_clear(mapping->removed);
+
+        /* the new file replaces the old one whole, as write_game_save_file() does */
+        temp_name = (char*) malloc(strlen(mapping->file_name) + 5);
+        strcpy(temp_name, mapping->file_name);
+        strcat(temp_name, ".tmp");
+
+        height = get_game_field_height(field);
+        mapping->width = field->width;
+        mapping->fd = open(temp_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (mapping->fd >= 0 && resize_field_mapping(mapping, height + MAPPING_SPARE_ROWS)) {
+            for (row = 0; row < height; row++) {
+                mapping_row_table_push(mapping->rows, row);
+                write_field_mapping_row(field, row);
+            }
+            mapping->used = height;
+
+            write_field_mapping_header(field);
+            res = msync(mapping->data, mapping->size, MS_SYNC) == 0 && rename(temp_name, mapping->file_name) == 0;
+        }
+
+        if (!res) {
+            printf("Error while serializing game file\nCant write in file: %s\n", mapping->file_name);
+            close_field_mapping_file(mapping);
+            remove(temp_name);
+        }
+
+        free(temp_name);
+    }
+
+    return res;
+}
+
+void sync_field_mapping(game_field *field, int wait) {
+    if (field->mapping != NULL && field->mapping->data != NULL) {
+        write_field_mapping_header(field);
+        msync(field->mapping->data, field->mapping->size, wait ? MS_SYNC : MS_ASYNC);
+    }
+}
+
+void update_field_mapping_cell(game_field *field, int index) {
+    field_mapping *mapping;
+
+    mapping = field->mapping;
+
+    if (mapping->data != NULL) {
+        get_field_mapping_row(mapping, mapping->rows->items[index / field->width])[1 + index % field->width] =
+            field->table->items[index] & MAPPING_CELL_MASK;
+    }
+}
+
+void update_field_mapping_appended(game_field *field, int first) {
+    field_mapping *mapping;
+    int i, row;
+
+    mapping = field->mapping;
+
+    for (i = first; i < (int) field->table->count && mapping->data != NULL; i++) {
+        row = i / field->width;
+
+        /* a new row goes after every row of the file, so that the file order stays the field order */
+        if (row >= (int) mapping->rows->count &&
+            (mapping->used < mapping->capacity || resize_field_mapping(mapping, 2 * mapping->capacity))) {
+            mapping_row_table_push(mapping->rows, mapping->used);
+            get_field_mapping_row(mapping, mapping->used)[0] = 1;
+            mapping->used++;
+        }
+
+        if (mapping->data != NULL)
+            update_field_mapping_cell(field, i);
+    }
+}
+
+void update_field_mapping_removed_row(game_field *field, int index) {
+    field_mapping *mapping;
+    int row;
+
+    mapping = field->mapping;
+
+    if (mapping->data != NULL) {
+        row = mapping_row_table_remove(mapping->rows, index);
+        get_field_mapping_row(mapping, row)[0] = 0;
+        mapping_row_table_push(mapping->removed, row);
+    }
+}
+
+void update_field_mapping_inserted_row(game_field *field, int index) {
+    field_mapping *mapping;
+    int row;
+
+    mapping = field->mapping;
+
+    if (mapping->data != NULL) {
+        row = mapping->removed->count > 0 ? mapping->removed->items[mapping->removed->count - 1] : -1;
+
+        /* the row of the file must sit between the rows of its neighbours */
+        if (row >= 0 &&
+            (index == 0 || mapping->rows->items[index - 1] < row) &&
+            (index == (int) mapping->rows->count || row < mapping->rows->items[index])) {
+            mapping_row_table_pop(mapping->removed);
+            mapping_row_table_insert(mapping->rows, row, index);
+            write_field_mapping_row(field, index);
+        } else {
+            reset_field_mapping(field);
+        }
+    }
+}
+
+void update_field_mapping_truncated(game_field *field) {
+    field_mapping *mapping;
+    int height;
+
+    mapping = field->mapping;
+    height = get_game_field_height(field);
+
+    while (mapping->data != NULL && (int) mapping->rows->count > height) {
+        get_field_mapping_row(mapping, mapping_row_table_pop(mapping->rows))[0] = 0;
+    }
+}
+
+int check_field_mapping_file(const unsigned char *data, size_t size) {
+    return size >= FIELD_MAPPING_HEADER_SIZE && memcmp(data, FIELD_MAPPING_MAGIC, 4) == 0;
+}
+
+game_field* read_field_mapping(const unsigned char *data, size_t size) {
+    game_field *res;
+    field_cell *cells;
+    const unsigned char *row;
+    size_t offset, count, number, i;
+    int width;
+
+    res = NULL;
+    width = check_field_mapping_file(data, size) ? (int) read_field_mapping_number(data + 4, 2) : 0;
+    count = width > 0 ? read_field_mapping_number(data + 12, 4) : 0;
+
+    /* the header of a foreign or corrupt file gives no field, and no more cells than its rows hold */
+    if (width > 0 && width <= 0x7FFF &&
+        count <= (size - FIELD_MAPPING_HEADER_SIZE) / (size_t) (width + 1) * (size_t) width)
+        res = create_new_game_field((short) width);
+
+    if (res != NULL) {
+        res->stage = (unsigned short) read_field_mapping_number(data + 6, 2);
+        res->score = (int) read_field_mapping_number(data + 8, 4);
+        res->additions_max = data[16] / 16 & 15;
+        res->additions_available = data[16] & 15;
+        res->hints_max = data[17] / 16 & 15;
+        res->hints_available = data[17] & 15;
+
+        res->random.seed = read_field_mapping_number(data + FIELD_MAPPING_RANDOM, 4);
+        for (i = 0; i < 4; i++) {
+            res->random.state[i] = read_field_mapping_number(data + FIELD_MAPPING_RANDOM + 4 * (i + 1), 4);
+        }
+
+        /* the rows on the field, in file order; the last one may be partly used */
+        cells = reserve_game_field_cells(res, (int) count);
+        number = 0;
+        offset = FIELD_MAPPING_HEADER_SIZE;
+
+        while (number < count && offset + width + 1 <= size) {
+            row = data + offset;
+
+            if (row[0] == 1) {
+                i = count - number < (size_t) width ? count - number : (size_t) width;
+                memcpy(cells + number, row + 1, i);
+                number += i;
+            }
+
+            offset += width + 1;
+        }
+
+        append_game_field_cells(res, (int) number);
+        res->count = (int) number;
+    }
+
+    return res;
+}
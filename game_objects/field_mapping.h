@@ -0,0 +1,181 @@
+/**
+ * @file field_mapping.h
+ * @brief Save file mapped in memory and written in place as the field changes.
+ *
+ * The save is mapped with mmap() and the game_field functions write each
+ * cell they change straight into the mapping, as they record it in the
+ * journal: a played pair writes the two bytes of its cells and nothing else.
+ * The counters of the header are written in place at each sync.
+ *
+ * The file keeps the rows where they were first written. Each row of the
+ * file starts with a flag telling whether it is on the field: removing a
+ * row clears its flag instead of moving the rows after it, and the mapping
+ * keeps in memory which row of the file each row of the field is.
+ *
+ * Layout, numbers least significant byte first:
+ * - magic FIELD_MAPPING_MAGIC (4), width (2), stage (2), score (4), number
+ *   of cells (4), additions and their maximum (1, max * 16 + available),
+ *   hints and their maximum (1), then the seed and the state of the
+ *   generator (5 x 4) at FIELD_MAPPING_RANDOM, up to FIELD_MAPPING_HEADER_SIZE;
+ * - then the rows, each 1 flag byte (1 if the row is on the field) and
+ *   @c width cells holding the value and the AVAILABLE and HIGHLITED flags.
+ *
+ * The rows on the field, in file order, hold the cells in reading order;
+ * only the last one may be partly used. The file is only consistent after
+ * sync_field_mapping(): in between, a crash may keep some cells of the last
+ * move without its counters.
+ */
+
+#ifndef FIELD_MAPPING_H
+#define FIELD_MAPPING_H
+
+#include"game_field.h"
+
+/**
+ * @brief First bytes of a mapped save.
+ */
+#define FIELD_MAPPING_MAGIC "NMMP"
+
+/**
+ * @brief Offset of the generator in the header.
+ */
+#define FIELD_MAPPING_RANDOM 22
+
+/**
+ * @brief Size of the header of a mapped save.
+ */
+#define FIELD_MAPPING_HEADER_SIZE 48
+
+/**
+ * @brief Rows of the file the field is on, in order.
+ */
+struct mapping_row_table {
+    int* items;
+    size_t count;
+    size_t capacity;
+};
+typedef struct mapping_row_table mapping_row_table;
+
+/**
+ * @brief Save file of a field, mapped in memory.
+ */
+struct field_mapping {
+    char *file_name;                /**< Path to the file. */
+    int fd;                         /**< Descriptor of the file, or -1. */
+    unsigned char *data;            /**< Mapped file, or NULL if the file could not be written. */
+    size_t size;                    /**< Size of the file and of the mapping. */
+    int width;                      /**< Width of the rows of the file. */
+    int capacity;                   /**< Rows the file has room for. */
+    int used;                       /**< Rows of the file written so far. */
+    mapping_row_table *rows;        /**< Row of the file of each row of the field. */
+    mapping_row_table *removed;     /**< Rows of the file removed from the field, last one on top. */
+};
+
+typedef struct field_mapping field_mapping;
+
+/**
+ * @brief Allocates the mapping of a field to a save file.
+ *
+ * Nothing is written before reset_field_mapping().
+ *
+ * @param[in] file_name Path to the file, copied.
+ *
+ * @return Pointer to the mapping.
+ */
+field_mapping* create_field_mapping(const char *file_name);
+
+/**
+ * @brief Syncs the file and frees the mapping.
+ *
+ * @param[in] mapping Pointer to the mapping; NULL is ignored.
+ */
+void free_field_mapping(field_mapping *mapping);
+
+/**
+ * @brief Writes the whole field to a new file and maps it in place of the old one.
+ *
+ * Used when a field gets its mapping and when a new stage replaces the
+ * board. The new file is written and synced under a temporary name, then
+ * renamed over the old one. If it fails, the mapping stops writing and the
+ * old file stays as it was.
+ *
+ * @param[in,out] field Pointer to the game_field; ignored if it has no mapping.
+ *
+ * @return 1 if the file holds the field, 0 otherwise.
+ */
+int reset_field_mapping(game_field *field);
+
+/**
+ * @brief Writes the header in place and syncs the file.
+ *
+ * @param[in,out] field Pointer to the game_field; ignored if it has no mapping.
+ * @param[in]     wait  1 to return once the file is on the disk, 0 to
+ *                      only schedule the write.
+ */
+void sync_field_mapping(game_field *field, int wait);
+
+/**
+ * @brief Writes a changed cell, called by the game_field functions.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     index Index of the cell.
+ */
+void update_field_mapping_cell(game_field *field, int index);
+
+/**
+ * @brief Writes appended cells, called by the game_field functions.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     first Index of the first appended cell.
+ */
+void update_field_mapping_appended(game_field *field, int first);
+
+/**
+ * @brief Takes a removed row off the field, called by the game_field functions.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     index Index the row had.
+ */
+void update_field_mapping_removed_row(game_field *field, int index);
+
+/**
+ * @brief Puts back the last removed row, called by the game_field functions.
+ *
+ * A row that is not the last removed one, which undo never does, rewrites
+ * the whole field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     index Index of the inserted row.
+ */
+void update_field_mapping_inserted_row(game_field *field, int index);
+
+/**
+ * @brief Takes the rows past the end of the field off it, called by the
+ *        game_field functions.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void update_field_mapping_truncated(game_field *field);
+
+/**
+ * @brief Checks whether bytes start with FIELD_MAPPING_MAGIC.
+ *
+ * @param[in] data Bytes of a file.
+ * @param[in] size Number of bytes.
+ *
+ * @return 1 for a mapped save, 0 otherwise.
+ */
+int check_field_mapping_file(const unsigned char *data, size_t size);
+
+/**
+ * @brief Builds the field a mapped save holds.
+ *
+ * @param[in] data Bytes of the file.
+ * @param[in] size Number of bytes.
+ *
+ * @return Pointer to a new game_field, or NULL if the header is invalid or
+ *         counts more cells than the rows of the file hold.
+ */
+game_field* read_field_mapping(const unsigned char *data, size_t size);
+
+#endif /* FIELD_MAPPING_H */
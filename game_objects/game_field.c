@@ -1,17 +1,16 @@
 #include"game_field.h"
+#include"match_index.h"
+#include"field_links.h"
+#include"field_hash.h"
+#include"field_journal.h"
+#include"field_mapping.h"
 
-#define VECTOR_TYPE field_cell*
-#define VECTOR_NAME field_row
-#define VECTOR_STRUCT_DEFINED
-#include "vector.h"
-
-#define VECTOR_TYPE field_row*
+#define VECTOR_TYPE field_cell
 #define VECTOR_NAME field_table
 #define VECTOR_STRUCT_DEFINED
 #include "vector.h"
 
 
-
 game_field* create_new_game_field(short width) {
     game_field *res;
 
@@ -30,6 +29,8 @@ game_field* create_new_game_field(short width) {
         res->additions_max = 5;
         res->additions_available = res->additions_max;
 
+        seed_game_random(&res->random, 0);
+
         init_game_field_table(res);
 
     } else {
@@ -41,90 +42,256 @@ game_field* create_new_game_field(short width) {
 
 void init_game_field_table(game_field *field) {
     field->table = field_table_create(0);
+    field->journal = NULL;
+    field->mapping = NULL;
+    init_match_index(field);
+    init_field_links(field);
+    init_field_hash(field);
+}
+
+game_field* copy_game_field(game_field *field) {
+    game_field *res;
+
+    res = (game_field*) malloc(sizeof(game_field));
+    *res = *field;
+
+    res->table = field_table_copy(field->table);
+    res->journal = NULL;
+    res->mapping = NULL;
+    copy_match_index(res, field);
+    copy_field_links(res, field);
+    copy_field_hash(res, field);
+
+    return res;
 }
 
 int get_game_field_height(game_field *field) {
-    return (int) field->table->count;
+    return (int) ((field->table->count + field->width - 1) / field->width);
 }
 
-void add_cell_game_field(game_field *field, field_cell *cell) {
-    field_row *row;
+void add_cell_game_field(game_field *field, field_cell cell) {
+    add_cells_game_field(field, &cell, 1);
+}
 
-    if (field->table->count != 0) {
-        row = field_table_tail(field->table);
+void add_cells_game_field(game_field *field, const field_cell *cells, int number) {
+    /* an empty field has no cells to copy to */
+    if (number > 0)
+        memcpy(reserve_game_field_cells(field, number), cells, number * sizeof(field_cell));
+    append_game_field_cells(field, number);
+}
 
-        if (row->count >= field->width) {
-            row = field_row_create(0);
-            field_table_push(field->table, row);
-        }
-    } else {
-        row = field_row_create(0);
-        field_table_push(field->table, row);
-    }
+field_cell* reserve_game_field_cells(game_field *field, int number) {
+    field_table_reserve(field->table, field->table->count + number);
 
-    field_row_push(row, cell);
+    return field->table->items + field->table->count;
+}
+
+void append_game_field_cells(game_field *field, int number) {
+    int first;
+
+    first = (int) field->table->count;
+    field->table->count += number;
+
+    update_field_links_appended(field, first);
+    update_match_index_appended(field, first);
+    update_field_hash_appended(field, first);
+
+    if (field->journal != NULL)
+        record_field_journal_appended(field, first);
+    if (field->mapping != NULL)
+        update_field_mapping_appended(field, first);
 }
 
 void add_values_game_field(game_field *field, short *values, int number) {
-    field_cell *cell;
-    int i = 0;
+    int i, first;
 
-    for (i = 0; i < number; i++) {
-        cell = (field_cell*) malloc(sizeof(field_cell));
-        *cell = create_field_cell(values[i]);
+    first = (int) field->table->count;
+    field_table_reserve(field->table, field->table->count + number);
 
-        add_cell_game_field(field, cell);
+    for (i = 0; i < number; i++) {
+        field->table->items[field->table->count++] = create_field_cell(values[i]);
     }
 
     field->count += number;
+    update_field_links_appended(field, first);
+    update_match_index_appended(field, first);
+    update_field_hash_appended(field, first);
+
+    if (field->journal != NULL)
+        record_field_journal_appended(field, first);
+    if (field->mapping != NULL)
+        update_field_mapping_appended(field, first);
+}
+
+void clear_game_field(game_field *field) {
+    field_table_clear(field->table);
+    clear_match_index(field);
+    clear_field_links(field);
+    clear_field_hash(field);
+    field->count = 0;
+
+    if (field->mapping != NULL)
+        update_field_mapping_truncated(field);
 }
 
 int remove_game_field_row(game_field *field, int index) {
-    field_row *row;
-    int res;
-    size_t i;
+    int res, i, row_size;
+
+    row_size = get_game_field_row_size(field, index);
 
-    if (index < 0 || field->table->count <= (size_t) index) {
+    if (row_size == 0) {
         res = 0;
     } else {
-        row = field_table_remove(field->table, index);
-
-        for (i = 0; i < row->count; i++) {
-            free(field_row_get(row, i));
+        for (i = 0; i < row_size; i++) {
+            set_available_game_field_cell(field, create_vector2i(i, index), 0);
         }
 
-        field->count -= row->count;
+        if (field->journal != NULL)
+            record_field_journal_row(field, index);
+
+        field_table_remove_range(field->table, (size_t) index * field->width, row_size);
+        update_field_links_removed_row(field, index);
+        update_match_index_removed_row(field, index);
+        update_field_hash_removed_row(field, index);
 
-        field_row_free(row);
+        if (field->mapping != NULL)
+            update_field_mapping_removed_row(field, index);
+
+        field->count -= row_size;
         res = 1;
     }
     
     return res;
 }
 
+/**
+ * @brief Rebuilds the match index, the links and the hash after the cells
+ *        were moved in place.
+ */
+static void reindex_game_field(game_field *field) {
+    rebuild_field_links(field);
+    rebuild_match_index(field);
+    clear_field_hash(field);
+    update_field_hash_appended(field, 0);
+}
+
+void insert_game_field_row(game_field *field, int index, const field_cell *cells, int number) {
+    size_t offset;
+    int i, available;
+
+    offset = (size_t) index * field->width;
+    field_table_reserve(field->table, field->table->count + number);
+
+    /* an empty table has no items to copy from or to */
+    if (number > 0) {
+        memmove(field->table->items + offset + number, field->table->items + offset,
+                (field->table->count - offset) * sizeof(field_cell));
+        memcpy(field->table->items + offset, cells, number * sizeof(field_cell));
+    }
+    field->table->count += number;
+
+    field->count += number;
+
+    available = 0;
+    for (i = 0; i < number; i++) {
+        available |= FIELD_CELL_IS_AVAILABLE(cells[i]);
+    }
+
+    /* a removed row comes back crossed out: only its neighbours are updated */
+    if (available) {
+        reindex_game_field(field);
+    } else {
+        update_field_links_inserted_row(field, index);
+        update_match_index_inserted_row(field, index);
+        update_field_hash_inserted_row(field, index);
+    }
+
+    if (field->mapping != NULL)
+        update_field_mapping_inserted_row(field, index);
+}
+
+void truncate_game_field(game_field *field, int first) {
+    /* the index first, while the links still reach the removed cells */
+    update_match_index_truncated(field, first);
+    update_field_links_truncated(field, first);
+
+    field->count -= (int) field->table->count - first;
+    field->table->count = first;
+
+    update_field_hash_truncated(field, first);
+
+    if (field->mapping != NULL)
+        update_field_mapping_truncated(field);
+}
+
+int duplicate_game_field_cells(game_field *field) {
+    field_cell *cells;
+    short *values;
+    int res, i, count, number;
+
+    if (field->additions_available > 0) {
+        cells = field->table->items;
+        count = (int) field->table->count;
+        values = (short*) malloc((count + 1) * sizeof(short));
+
+        /* collect the values first: appending may move the cell buffer */
+        number = 0;
+        for (i = 0; i < count; i++) {
+            if (FIELD_CELL_IS_AVAILABLE(cells[i])) {
+                values[number++] = FIELD_CELL_VALUE(cells[i]);
+            }
+        }
+
+        add_values_game_field(field, values, number);
+        free(values);
+
+        field->additions_available--;
+        res = 1;
+    } else {
+        res = 0;
+    }
+
+    return res;
+}
+
 int get_game_field_row_size(game_field *field, int index) {
-    int res;
+    int res, height;
+
+    height = get_game_field_height(field);
 
-    if (index < 0 || field->table->count <= (size_t) index) {
+    if (index < 0 || height <= index) {
         res = 0;
+    } else if (index < height - 1) {
+        res = field->width;
     } else {
-        res = (int) field_table_get(field->table, index)->count;
+        res = (int) field->table->count - index * field->width;
     } 
 
     return res;
 }
 
+field_cell* get_game_field_row(game_field *field, int index) {
+    field_cell *res;
+
+    if (index < 0 || get_game_field_height(field) <= index)
+        res = NULL;
+    else
+        res = field->table->items + (size_t) index * field->width;
+
+    return res;
+}
+
 field_cell* get_game_field_cell(game_field *field, vector2i pos) {
     field_cell *res;
-    field_row *row;
+    size_t index;
 
-    if (pos.x < 0 || pos.x >= get_game_field_row_size(field, pos.y) ||
-        pos.y < 0 || pos.y >= get_game_field_height(field))
+    index = (size_t) pos.y * field->width + pos.x;
+
+    if (pos.x < 0 || pos.x >= field->width || pos.y < 0 ||
+        index >= field->table->count)
         res = NULL;
-    else {
-        row = field_table_get(field->table, pos.y);
-        res = field_row_get(row, pos.x);
-    }
+    else
+        res = field->table->items + index;
 
     return res;
 }
@@ -139,14 +306,14 @@ int get_available_game_field_cell(game_field *field, vector2i pos) {
         res = 0;
     }
     else {
-        res = cell->is_available;
+        res = FIELD_CELL_IS_AVAILABLE(*cell);
     }
     
     return res;
 }
 
 int set_highlight_game_field_cell(game_field *field, vector2i pos, int value) {
-    field_cell *cell;
+    field_cell *cell, previous;
     int res;
 
     cell = get_game_field_cell(field, pos);
@@ -155,7 +322,13 @@ int set_highlight_game_field_cell(game_field *field, vector2i pos, int value) {
         res = 0;
     }
     else {
-        cell->is_highlited = value;
+        previous = *cell;
+        *cell = FIELD_CELL_SET_FLAG(*cell, FIELD_CELL_HIGHLITED, value);
+
+        if (field->journal != NULL)
+            record_field_journal_cell(field, (int) (cell - field->table->items), previous);
+        if (field->mapping != NULL)
+            update_field_mapping_cell(field, pos.y * field->width + pos.x);
         res = 1;
     }
     
@@ -172,7 +345,7 @@ int set_selection_game_field_cell(game_field *field, vector2i pos, int value) {
         res = 0;
     }
     else {
-        cell->is_selected = value;
+        *cell = FIELD_CELL_SET_FLAG(*cell, FIELD_CELL_SELECTED, value);
         res = 1;
     }
     
@@ -180,8 +353,8 @@ int set_selection_game_field_cell(game_field *field, vector2i pos, int value) {
 }
 
 int set_available_game_field_cell(game_field *field, vector2i pos, int value) {
-    field_cell *cell;
-    int res;
+    field_cell *cell, previous;
+    int res, index;
 
     cell = get_game_field_cell(field, pos);
 
@@ -189,7 +362,24 @@ int set_available_game_field_cell(game_field *field, vector2i pos, int value) {
         res = 0;
     }
     else {
-        cell->is_available = value;
+        if (FIELD_CELL_IS_AVAILABLE(*cell) != (value != 0)) {
+            previous = *cell;
+            *cell = FIELD_CELL_SET_FLAG(*cell, FIELD_CELL_AVAILABLE, value);
+            index = pos.y * field->width + pos.x;
+
+            if (value)
+                relink_field_cell(field, index);
+            else
+                unlink_field_cell(field, index);
+
+            update_match_index_cell(field, index);
+            update_field_hash_cell(field, index, previous);
+
+            if (field->journal != NULL)
+                record_field_journal_cell(field, index, previous);
+            if (field->mapping != NULL)
+                update_field_mapping_cell(field, index);
+        }
         res = 1;
     }
     
@@ -206,7 +396,7 @@ int set_cursor_game_field_cell(game_field *field, vector2i pos, int value) {
         res = 0;
     }
     else {
-        cell->is_cursor = value;
+        *cell = FIELD_CELL_SET_FLAG(*cell, FIELD_CELL_CURSOR, value);
         res = 1;
     }
     
@@ -214,217 +404,191 @@ int set_cursor_game_field_cell(game_field *field, vector2i pos, int value) {
 }
 
 int find_match(game_field *field, vector2i *start_p, vector2i *end_p) {
-    int res, i, j, row_size, d;
-    vector2i cursor_p, tmp_p;
-    field_cell *cursor_cell, *tmp_c;
+    int res, start, end;
 
-    res = 0;
-    for(i = 0; res == 0 && i < get_game_field_height(field); i++) {
-        row_size = get_game_field_row_size(field, i);
+    res = get_match_index_pair(field, &start, &end);
 
-        for(j = 0; res == 0 && j < row_size; j++) {
+    if (res) {
+        *start_p = create_vector2i(start % field->width, start / field->width);
+        *end_p = create_vector2i(end % field->width, end / field->width);
+    }
+    
+    return res;
+}
 
-            cursor_p = create_vector2i(j, i);
-            cursor_cell = get_game_field_cell(field, cursor_p);
+/**
+ * @brief Direction in which check_match() looks for @p end_p from @p start_p,
+ *        the two cells being in reading order.
+ */
+static MATCH_DIRECTION get_match_direction(vector2i start_p, vector2i end_p) {
+    vector2i delta;
+    MATCH_DIRECTION res;
+
+    delta = get_vector2i_to(start_p, end_p);
+
+    /* Horizontal, vertical or diagonal alignment, else “next line” */
+    if (delta.y != 0 && delta.x == 0)
+        res = COLUMN_MATCH_DIRECTION;
+    else if (delta.y != 0 && delta.x == -delta.y)
+        res = LEFT_DIAGONAL_MATCH_DIRECTION;
+    else if (delta.y != 0 && delta.x == delta.y)
+        res = RIGHT_DIAGONAL_MATCH_DIRECTION;
+    else
+        res = NEXT_CELL_MATCH_DIRECTION;
 
+    return res;
+}
 
-            if (cursor_cell != NULL && cursor_cell->is_available) {
+/**
+ * @brief Type of the match between two linked cells, @p end being the next
+ *        available cell after @p start in @p direction.
+ */
+static MATCH_TYPE get_linked_match_type(game_field *field, int start, int end, MATCH_DIRECTION direction) {
+    int direct, next_line;
+    MATCH_TYPE res;
 
-                /* check on column match */
-                tmp_p = cursor_p;
-                
-                do {
-                    tmp_p.y++;
-                    
-                    tmp_c = get_game_field_cell(field, tmp_p);
+    next_line = end / field->width != start / field->width;
 
+    if (direction == NEXT_CELL_MATCH_DIRECTION)
+        direct = end - start == 1;
+    else
+        direct = end / field->width - start / field->width == 1;
 
-                    if (tmp_c != NULL && tmp_c->is_available) {
-                        if (check_field_cell_math(cursor_cell, tmp_c)) {
-                            res = 1;
-                            *start_p = cursor_p;
-                            *end_p = tmp_p;
-                        } else {
-                            tmp_c = NULL;
-                        } 
-                    }
-                } while (res == 0 && tmp_c != NULL);
-
-                /* check on diagonal left and right match */
-                for (d = -1; d <= 1; d += 2) {
-
-                    tmp_p = cursor_p;
-
-                    do {
-                        tmp_p.x += d;
-                        tmp_p.y++;
-                    
-                        tmp_c = get_game_field_cell(field, tmp_p);
-
-                        if (tmp_c != NULL && tmp_c->is_available) {
-                            if (check_field_cell_math(cursor_cell, tmp_c)) {
-                                res = 1;
-                                *start_p = cursor_p;
-                                *end_p = tmp_p;
-                            } else {
-                                tmp_c = NULL;
-                            } 
-                        }
-                    } while (res == 0 && tmp_c != NULL);
-                }
+    if (direct && direction == NEXT_CELL_MATCH_DIRECTION && next_line)
+        res = NEXT_LINE_MATCH;
+    else if (direct)
+        res = DIRECTE_MATCH;
+    else
+        res = DISTANCE_MATCH;
+
+    return res;
+}
+
+int find_all_matches(game_field *field, field_match *matches, int capacity) {
+    unsigned char *masks;
+    int res, i, d, end, count, seen;
+    vector2i start_p, end_p;
 
-                /* check on horisontal and next line check */
-                tmp_p = cursor_p;
-                
-                do {
-                    tmp_p.x++;
-                    
-                    tmp_c = get_game_field_cell(field, tmp_p);
-
-                    if (tmp_c == NULL) {
-                        if (tmp_p.y < get_game_field_height(field) - 1) {
-                            tmp_p.x = -1;
-                            tmp_p.y++;
-
-                            /* for continue while cycle */
-                            tmp_c = cursor_cell;
-                        }
-                    } else if (tmp_c != NULL && tmp_c->is_available) {
-                        if (check_field_cell_math(cursor_cell, tmp_c)) {
-                            res = 1;
-                            *start_p = cursor_p;
-                            *end_p = tmp_p;
-                        } else {
-                            tmp_c = NULL;
-                        } 
+    masks = field->matches->items;
+    count = (int) field->matches->count;
+
+    res = 0;
+    seen = 0;
+    for (i = field->matches_first; seen < field->matches_count && i < count; i++) {
+        for (d = 0; masks[i] != 0 && d < MATCH_DIRECTIONS_COUNT; d++) {
+            if (masks[i] & 1 << d) {
+                end = get_next_linked_cell(field, i, d);
+                start_p = create_vector2i(i % field->width, i / field->width);
+                end_p = create_vector2i(end % field->width, end / field->width);
+
+                /* a pair also linked along a line is listed from that line only */
+                if (get_match_direction(start_p, end_p) == (MATCH_DIRECTION) d) {
+                    if (res < capacity) {
+                        matches[res].start = start_p;
+                        matches[res].end = end_p;
+                        matches[res].type = get_linked_match_type(field, i, end, d);
                     }
-                } while (res == 0 && tmp_c != NULL);
+                    res++;
+                }
+                seen++;
             }
         }
     }
-    
+
     return res;
 }
 
-int check_match(game_field *field, vector2i start_p, vector2i end_p) {
-    int next_line = 0, is_direct;
-    vector2i current_p, direction, abs_delta, tmp;
-    field_cell *start_cell, *end_cell, *current_cell;
-    MATCH_TYPE res = NONE_MATCH;
+int count_game_field_matches(game_field *field) {
+    return find_all_matches(field, NULL, 0);
+}
 
+int check_match(game_field *field, vector2i start_p, vector2i end_p) {
+    int start, end;
+    vector2i tmp;
+    MATCH_DIRECTION direction;
+    MATCH_TYPE res;
 
     /* Swap cells if the end point appears before the start point */
-    if (start_p.y > end_p.y) {
+    if (start_p.y > end_p.y || (start_p.y == end_p.y && start_p.x > end_p.x)) {
         tmp = start_p;
         start_p = end_p;
         end_p = tmp;
     }
-    
-    start_cell = get_game_field_cell(field, start_p);
-    end_cell = get_game_field_cell(field, end_p);
-    
-    abs_delta = abs_vector2i(get_vector2i_to(start_p, end_p));
 
     /* Return NOT_MATCH if cells cannot be matched */
-    if (!check_field_cell_math(start_cell, end_cell)) {
+    if (!check_field_cell_math(get_game_field_cell(field, start_p), get_game_field_cell(field, end_p))) {
         res = NOT_MATCH;
-    
-    /* Check for direct horizontal, vertical, or diagonal alignment */
-    } else if (abs_delta.x == 0 || abs_delta.y == 0 || abs_delta.x == abs_delta.y) {
-        direction = get_direction_to(start_p, end_p);
-    /* Check for “next line” match (wrapping to a new line) */
-    } else if (start_p.y < end_p.y) {
-        direction = create_vector2i(1, 0);
-        next_line = 1;
-    /* Default: not a valid match */
     } else {
-        res = NOT_MATCH;
-    }
+        direction = get_match_direction(start_p, end_p);
 
-    /* If still valid, begin match path iteration */
-    current_p = start_p;
-    is_direct = 1;
-    while (res == NONE_MATCH) {
-        
-        /* Move to the next cell along the direction */
-        current_p = add_vector2i(current_p, direction);
-        current_cell = get_game_field_cell(field, current_p);
-
-        /* Reached target cell — determine match type */
-        if (current_cell == end_cell) {
-            if (is_direct && next_line)
-                res = NEXT_LINE_MATCH;
-            else if (is_direct)
-                res = DIRECTE_MATCH;
-            else
-                res = DISTANCE_MATCH;
-        /* Out of field — possibly move to next line */
-        } else if (current_cell == NULL) {
-            if (next_line && current_p.y < get_game_field_height(field) - 1) {
-                current_p.y += 1;
-                current_p.x = -1;
-            } else {
-                res = NOT_MATCH;
-            }
-        /* Found an occupied cell before reaching end — not valid */
-        } else if (current_cell->is_available) {
+        start = start_p.y * field->width + start_p.x;
+        end = end_p.y * field->width + end_p.x;
+
+        /* Only empty cells may lie between the two cells */
+        if (get_next_linked_cell(field, start, direction) != end)
             res = NOT_MATCH;
-        /* Passed through empty cells — mark as indirect */
-        } else {
-            is_direct = 0;
-        }
+        else
+            res = get_linked_match_type(field, start, end, direction);
     }
 
     return res;
 }
 
-int check_game_row_is_clear(game_field *field, int index) {
-    int res, i, row_size;
+MATCH_TYPE play_game_field_match(game_field *field, vector2i *start_p, vector2i *end_p) {
+    MATCH_TYPE res;
 
-    if (index < 0 || get_game_field_height(field) <= index) {
-        res = 0;
-    } else {
-        res = 1;
-        row_size = get_game_field_row_size(field, index);
-        
-        for (i = 0; res == 1 && i < row_size; i++) {
-            if (get_available_game_field_cell(field, create_vector2i(i, index))) {
-                res = 0;
-            }
-        }
-    }
+    res = check_match(field, *start_p, *end_p);
 
-    return res;
-}
+    if (res) {
+        set_available_game_field_cell(field, *start_p, 0);
+        set_available_game_field_cell(field, *end_p, 0);
 
-int check_game_field_is_clear(game_field *field) {
-    int res, i, j, rest;
-    vector2i tmp;
+        if (check_game_row_is_clear(field, end_p->y)) {
+            remove_game_field_row(field, end_p->y);
+            res += CLEAR_LINE_MATCH;
 
-    res = 1;
-    
-    for (i = 0; res == 1 && i < get_game_field_height(field) - 1; i++) {
-        for (j = 0; res == 1 && j < field->width; j++) {
+            if (start_p->y > end_p->y)
+                start_p->y--;
 
-            tmp = create_vector2i(j, i);
-            if (get_available_game_field_cell(field, tmp))
-                res = 0;
+            end_p->y--;
         }
+
+        if (check_game_row_is_clear(field, start_p->y)) {
+            remove_game_field_row(field, start_p->y);
+            res += CLEAR_LINE_MATCH;
+            end_p->y--;
+        }
+
+        field->score += res;
     }
 
-    rest = field->count % field->width;
-    for (j = 0; res == 1 && j < rest; j++) {
+    return res;
+}
+
+int check_game_row_is_clear(game_field *field, int index) {
+    field_cell *row;
+    int res;
 
-        tmp = create_vector2i(j, field->table->count - 1);
-        if (get_available_game_field_cell(field, tmp))
-                res = 0;
+    row = get_game_field_row(field, index);
+
+    if (row == NULL) {
+        res = 0;
+    } else {
+        res = !check_field_cells_available(row, get_game_field_row_size(field, index));
     }
 
     return res;
 }
 
+int check_game_field_is_clear(game_field *field) {
+    return !check_field_cells_available(field->table->items, field->table->count);
+}
+
 
 void game_field_free(game_field *field) {
     field_table_free(field->table);
+    free_match_index(field);
+    free_field_links(field);
+    free_field_hash(field);
     free(field);
 }
\ No newline at end of file
@@ -20,21 +20,61 @@
 #include<stdio.h>
 #include"field_cell.h"
 #include"vector2i.h"
+#include"game_random.h"
 
-struct field_row {
-    field_cell** items;              /**< Dynamic array of cell pointers within a single row. */
-    size_t count;                    /**< Current number of cells in the row. */
-    size_t capacity;                 /**< Allocated capacity of the row. */
-};
-typedef struct field_row field_row;
-
+/**
+ * @brief Contiguous storage of all the cells of the field.
+ *
+ * Cells are kept in reading order in a single buffer. Every row except the
+ * last one is always full, so row @c y starts at offset @c y * width and the
+ * row-offset index is computed rather than stored.
+ */
 struct field_table {
-    field_row** items;              /**< Dynamic array of row pointers forming the grid. */
-    size_t count;                   /**< Current number of rows in the table. */
-    size_t capacity;                /**< Allocated capacity for rows. */
+    field_cell* items;              /**< Contiguous buffer of cells in reading order. */
+    size_t count;                   /**< Current number of cells in the table. */
+    size_t capacity;                /**< Allocated capacity of the buffer, in cells. */
 };
 typedef struct field_table field_table;
 
+/**
+ * @brief Per-cell bitmasks of the valid pairs, see match_index.h.
+ */
+struct match_table {
+    unsigned char* items;           /**< One mask of MATCH_DIRECTION bits per cell. */
+    size_t count;                   /**< Number of masks, equal to the number of cells. */
+    size_t capacity;                /**< Allocated capacity of the buffer. */
+};
+typedef struct match_table match_table;
+
+/**
+ * @brief Nearest available neighbours of a cell, see field_links.h.
+ */
+struct cell_links {
+    int next[4];                    /**< Next available cell in each MATCH_DIRECTION, or -1. */
+    int previous[4];                /**< Previous available cell in each MATCH_DIRECTION, or -1. */
+};
+typedef struct cell_links cell_links;
+
+/**
+ * @brief Per-cell neighbour links, parallel to the field_table.
+ */
+struct links_table {
+    cell_links* items;              /**< Links of each cell in reading order. */
+    size_t count;                   /**< Number of entries, equal to the number of cells. */
+    size_t capacity;                /**< Allocated capacity of the buffer. */
+};
+typedef struct links_table links_table;
+
+/**
+ * @brief Hash of each row of the field, see field_hash.h.
+ */
+struct row_hash_table {
+    unsigned long* items;           /**< XOR of the keys of the cells of each row. */
+    size_t count;                   /**< Number of rows. */
+    size_t capacity;                /**< Allocated capacity of the buffer. */
+};
+typedef struct row_hash_table row_hash_table;
+
 /**
  * @brief Represents the complete NumberMatch game field and its runtime state.
  *
@@ -42,7 +82,16 @@ typedef struct field_table field_table;
  * counters such as score, stage progression, available hints, and additions.
  */
 struct game_field {
-    field_table *table;                 /**< 2D grid of game cells. */
+    field_table *table;                 /**< Contiguous grid of game cells. */
+
+    match_table *matches;               /**< Index of the valid pairs, kept in sync with the table. */
+    int matches_count;                  /**< Number of valid pairs on the field. */
+    int matches_first;                  /**< No cell before this index starts a valid pair. */
+
+    links_table *links;                 /**< Nearest available neighbours of every cell. */
+
+    row_hash_table *row_hashes;         /**< Hash of each row of the table. */
+    unsigned long hash;                 /**< Hash of the cells, kept in sync with the table. */
 
     int score;                          /**< Current player score. */
     int count;                          /**< Number of active (non-empty) cells. */
@@ -55,6 +104,11 @@ struct game_field {
 
     unsigned short additions_available; /**< Remaining additions (expansions) available. */
     unsigned short additions_max;       /**< Maximum number of additions allowed. */
+
+    game_random random;                 /**< Generator of the boards of this game. */
+
+    struct field_journal *journal;      /**< Journal recording the moves, see field_journal.h; may be NULL. */
+    struct field_mapping *mapping;      /**< Save file written in place, see field_mapping.h; may be NULL. */
 };
 
 typedef struct game_field game_field;
@@ -79,6 +133,17 @@ enum MATCH_TYPE {
 
 typedef enum MATCH_TYPE MATCH_TYPE;
 
+/**
+ * @brief A valid pair of cells, as listed by find_all_matches().
+ */
+struct field_match {
+    vector2i start;          /**< First cell of the pair in reading order. */
+    vector2i end;            /**< Second cell of the pair. */
+    MATCH_TYPE type;         /**< Kind of match, as check_match() reports it. */
+};
+
+typedef struct field_match field_match;
+
 
 /**  
  * @brief Creates and initializes a new game field with the specified width.
@@ -96,13 +161,26 @@ game_field* create_new_game_field(short width);
 /**
  * @brief Initializes the table of the game field.
  *
- * Allocates an empty field_table and assigns it to the given game_field.
- * The table is created with zero initial rows.
+ * Allocates an empty field_table, match index, neighbour links and hash and
+ * assigns them to the given game_field. The table is created with zero
+ * initial rows.
  *
  * @param[in,out] field Pointer to the game_field to initialize.
  */
 void init_game_field_table(game_field *field);
 
+/**
+ * @brief Creates an independent copy of a game field.
+ *
+ * The cells, the match index and the neighbour links are duplicated, so the
+ * copy can be played without touching the original. The copy has no journal.
+ *
+ * @param[in] field Pointer to the game_field to copy.
+ *
+ * @return Pointer to the newly allocated copy.
+ */
+game_field* copy_game_field(game_field *field);
+
 /**
  * @brief Returns the current height of the game field.
  *
@@ -116,18 +194,51 @@ int get_game_field_height(game_field *field);
 /**
  * @brief Adds a new cell to the game field, automatically creating rows as needed.
  *
- * This function appends a cell to the last row of the game field.  
- * If the field has no rows yet, a new row is created.  
- * If the last row is already full (based on field->width), a new row is created
- * and the cell is added there.
+ * This function appends a copy of the cell at the end of the cell buffer.  
+ * A new row starts implicitly every `field->width` cells.
  *
  * @param[in,out] field Pointer to the game_field structure being modified.
- * @param[in]     cell  Pointer to the cell to add to the field.
+ * @param[in]     cell  Cell to add to the field.
+ *
+ * @note The field does not update `field->count`; callers adding cells one
+ *       by one are expected to keep it in sync.
+ */
+void add_cell_game_field(game_field *field, field_cell cell);
+
+/**
+ * @brief Appends a run of cells, flags included, to the game field.
+ *
+ * @param[in,out] field  Pointer to the game_field structure being modified.
+ * @param[in]     cells  Cells to copy at the end of the field.
+ * @param[in]     number Number of cells to copy.
  *
- * @note Rows grow automatically; the function ensures the field maintains a
- *       rectangular structure defined by `field->width`.
+ * @note Like add_cell_game_field(), `field->count` is left to the caller.
  */
-void add_cell_game_field(game_field *field, field_cell *cell);
+void add_cells_game_field(game_field *field, const field_cell *cells, int number);
+
+/**
+ * @brief Makes room for cells at the end of the game field, to be written in place.
+ *
+ * Lets a loader decode cells straight into the field instead of through a
+ * buffer; the cells are only part of the field after append_game_field_cells().
+ *
+ * @param[in,out] field  Pointer to the game_field structure being modified.
+ * @param[in]     number Number of cells to make room for.
+ *
+ * @return Pointer to the first of the @p number cells, valid until the field
+ *         is modified again.
+ */
+field_cell* reserve_game_field_cells(game_field *field, int number);
+
+/**
+ * @brief Appends the cells written after reserve_game_field_cells() to the game field.
+ *
+ * @param[in,out] field  Pointer to the game_field structure being modified.
+ * @param[in]     number Number of cells written, at most the number reserved.
+ *
+ * @note Like add_cell_game_field(), `field->count` is left to the caller.
+ */
+void append_game_field_cells(game_field *field, int number);
 
 /**  
  * @brief Adds new cell values to the game field sequentially.
@@ -140,15 +251,28 @@ void add_cell_game_field(game_field *field, field_cell *cell);
  * @param values[in] Array of short integers containing the values to insert
  * @param number[in] Number of values to add from the array
  *
- * @note Does nothing if the provided field pointer is NULL.
+ * @note The cell buffer grows at most once per call, whatever the number
+ *       of values added.
  */
 void add_values_game_field(game_field *field, short *values, int number);
 
+/**
+ * @brief Removes every cell from the game field.
+ *
+ * The cell buffer keeps its allocated memory so that the next fill of the
+ * field does not need to allocate again.
+ *
+ * @param[in,out] field Pointer to the game_field structure to clear.
+ */
+void clear_game_field(game_field *field);
+
 /**  
  * @brief Removes a row from the game field by its index.
  *
  * Deletes the specified row from the field's internal table, 
  * shifting all subsequent rows up and updating the field height.
+ * Available cells of the row are crossed out first so the match index
+ * stays consistent.
  *
  * @param field[in/out] Pointer to the game_field structure
  * @param index[in] Row index to remove
@@ -157,6 +281,44 @@ void add_values_game_field(game_field *field, short *values, int number);
  */
 int remove_game_field_row(game_field *field, int index);
 
+/**
+ * @brief Puts a row of cells back into the game field.
+ *
+ * The reverse of remove_game_field_row(): the rows from @p index on move
+ * down. For a row without available cells, only the diagonals crossing it
+ * are linked and indexed again; otherwise the match index, links and hash
+ * are rebuilt.
+ *
+ * @param[in,out] field  Pointer to the game_field structure
+ * @param[in]     index  Row index of the inserted row
+ * @param[in]     cells  Cells of the row, flags included
+ * @param[in]     number Number of cells; less than the width only for the last row
+ */
+void insert_game_field_row(game_field *field, int index, const field_cell *cells, int number);
+
+/**
+ * @brief Removes every cell from a given index to the end of the field.
+ *
+ * The reverse of appending cells: only the cells linked to the removed ones
+ * and the last row kept are indexed again.
+ *
+ * @param[in,out] field Pointer to the game_field structure
+ * @param[in]     first Index of the first cell removed
+ */
+void truncate_game_field(game_field *field, int first);
+
+/**
+ * @brief Appends a copy of the values of all available cells to the field.
+ *
+ * This is the "addition" move of the game: it consumes one of the
+ * additions available.
+ *
+ * @param[in,out] field Pointer to the game_field structure
+ *
+ * @return int Returns 1 if the cells were appended, 0 if no addition is available.
+ */
+int duplicate_game_field_cells(game_field *field);
+
 /**  
  * @brief Returns the number of cells in a specific row of the game field.
  *
@@ -168,12 +330,29 @@ int remove_game_field_row(game_field *field, int index);
 int get_game_field_row_size(game_field *field, int index);
 
 /**  
- * @brief Checks whether a specific cell in the game field is available.
+ * @brief Returns a pointer to the first cell of a row.
+ *
+ * The cells of a row are contiguous, so the next
+ * get_game_field_row_size() cells can be read directly from the pointer.
+ *
+ * @param[in] field Pointer to the game_field structure
+ * @param[in] index Row index
+ *
+ * @return field_cell* Pointer to the first cell of the row, or NULL if the index is invalid
+ *
+ * @note The pointer is invalidated by any call that adds or removes cells.
+ */
+field_cell* get_game_field_row(game_field *field, int index);
+
+/**  
+ * @brief Returns a pointer to a specific cell of the game field.
  *
  * @param[in] field Pointer to the game_field structure
  * @param[in] pos   Cell position (x, y) within the field
  *
- * @return int Returns 1 if the cell exists and is available, otherwise 0
+ * @return field_cell* Pointer to the cell, or NULL if the position is outside the field
+ *
+ * @note The pointer is invalidated by any call that adds or removes cells.
  */
 field_cell* get_game_field_cell(game_field *field, vector2i pos);
 
@@ -234,6 +413,11 @@ int set_cursor_game_field_cell(game_field *field, vector2i pos, int value);
 /**  
  * @brief Searches the game field for a valid match according to NumberMatch rules.
  *
+ * Cells are scanned in reading order; for each available cell the column,
+ * left diagonal, right diagonal and then the horizontal / next line
+ * directions are tried, and the first valid pair is returned.
+ * The answer comes from the match index, so it does not rescan the field.
+ *
  * @param[in]  field   Pointer to the game_field structure
  * @param[out] start_p Pointer to a vector2i that will store the start cell of the match
  * @param[out] end_p   Pointer to a vector2i that will store the end cell of the match
@@ -242,9 +426,42 @@ int set_cursor_game_field_cell(game_field *field, vector2i pos, int value);
  */
 int find_match(game_field *field, vector2i *start_p, vector2i *end_p);
 
+/**  
+ * @brief Lists every valid pair of the field.
+ *
+ * Pairs are listed in the order find_match() would find them: by first cell
+ * in reading order, then column, left diagonal, right diagonal and
+ * horizontal / next line. Each pair is listed once, even when it is also
+ * reachable in reading order. They are read from the match index in one
+ * pass, without any allocation.
+ *
+ * @param[in]  field    Pointer to the game_field structure
+ * @param[out] matches  Caller-provided array receiving the pairs
+ * @param[in]  capacity Number of elements of @p matches
+ *
+ * @return int Total number of valid pairs; only the first @p capacity of
+ *             them are written, so a larger value means the array was too small
+ */
+int find_all_matches(game_field *field, field_match *matches, int capacity);
+
+/**  
+ * @brief Returns the number of valid pairs currently on the field.
+ *
+ * The pairs are the ones find_all_matches() lists: a pair reachable both
+ * along a line and in reading order is counted once.
+ *
+ * @param[in] field Pointer to the game_field structure
+ *
+ * @return int Number of pairs of cells that can be matched right now
+ */
+int count_game_field_matches(game_field *field);
+
 /**  
  * @brief Checks whether two cells in the game field can form a valid match.
  *
+ * The cells between them are skipped through the neighbour links of
+ * field_links.h, so the cost does not depend on their distance.
+ *
  * @param[in]  field   Pointer to the game_field structure
  * @param[in]  start_p Starting cell position (x, y)
  * @param[in]  end_p   Ending cell position (x, y)
@@ -254,6 +471,22 @@ int find_match(game_field *field, vector2i *start_p, vector2i *end_p);
  */
 MATCH_TYPE check_match(game_field *field, vector2i start_p, vector2i end_p);
 
+/**  
+ * @brief Plays a pair of cells if they form a valid match.
+ *
+ * Both cells are crossed out, the rows left without available cells are
+ * removed (the row of @p end_p first), and the score grows by the match type
+ * plus CLEAR_LINE_MATCH for each removed row.
+ *
+ * @param[in,out] field   Pointer to the game_field structure
+ * @param[in,out] start_p First cell of the pair; moved up when a row above it is removed
+ * @param[in,out] end_p   Second cell of the pair; moved up when a row is removed
+ *
+ * @return MATCH_TYPE Points earned by the move, or NOT_MATCH (0) if the
+ *                    cells do not match and the field is unchanged
+ */
+MATCH_TYPE play_game_field_match(game_field *field, vector2i *start_p, vector2i *end_p);
+
 /**  
  * @brief Checks if a specific row in the game field is completely cleared.
  *
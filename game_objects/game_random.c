@@ -0,0 +1,109 @@
+#include"game_random.h"
+
+#define RANDOM_MASK 0xFFFFFFFFUL
+
+/* a rotation of a 32-bit word */
+#define RANDOM_ROTATE(value, bits) \
+    ((((value) << (bits)) | ((value) >> (32 - (bits)))) & RANDOM_MASK)
+
+
+/**
+ * @brief splitmix32 step, spreads a seed over the state words.
+ */
+static unsigned long mix_game_random_seed(unsigned long *seed) {
+    unsigned long value;
+
+    *seed = (*seed + 0x9E3779B9UL) & RANDOM_MASK;
+
+    value = *seed;
+    value = ((value ^ (value >> 16)) * 0x85EBCA6BUL) & RANDOM_MASK;
+    value = ((value ^ (value >> 13)) * 0xC2B2AE35UL) & RANDOM_MASK;
+
+    return value ^ (value >> 16);
+}
+
+void seed_game_random(game_random *random, unsigned long seed) {
+    unsigned long value;
+    int i;
+
+    random->seed = seed & RANDOM_MASK;
+
+    value = random->seed;
+    for (i = 0; i < 4; i++) {
+        random->state[i] = mix_game_random_seed(&value);
+    }
+
+    /* the only state the generator cannot leave */
+    if ((random->state[0] | random->state[1] | random->state[2] | random->state[3]) == 0)
+        random->state[0] = 1;
+}
+
+unsigned long next_game_random(game_random *random) {
+    unsigned long *s, res, t;
+
+    s = random->state;
+
+    res = RANDOM_ROTATE((s[1] * 5) & RANDOM_MASK, 7) * 9 & RANDOM_MASK;
+    t = (s[1] << 9) & RANDOM_MASK;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RANDOM_ROTATE(s[3], 11);
+
+    return res;
+}
+
+short next_game_random_range(game_random *random, short start, short end) {
+    unsigned long span;
+
+    span = (unsigned long) (end - start + 1);
+
+    /* the high 16 bits scaled to the span: a multiplication instead of a modulo */
+    return (short) (start + (long) ((next_game_random(random) >> 16) * span >> 16));
+}
+
+/**
+ * @brief Advances the generator by the distance a jump polynomial stands for.
+ */
+static void apply_game_random_jump(game_random *random, const unsigned long jump[4]) {
+    unsigned long s[4];
+    int i, bit;
+
+    s[0] = s[1] = s[2] = s[3] = 0;
+
+    for (i = 0; i < 4; i++) {
+        for (bit = 0; bit < 32; bit++) {
+            if (jump[i] >> bit & 1) {
+                s[0] ^= random->state[0];
+                s[1] ^= random->state[1];
+                s[2] ^= random->state[2];
+                s[3] ^= random->state[3];
+            }
+            next_game_random(random);
+        }
+    }
+
+    for (i = 0; i < 4; i++) {
+        random->state[i] = s[i];
+    }
+}
+
+void jump_game_random(game_random *random) {
+    static const unsigned long jump[4] = { 0x8764000BUL, 0xF542D2D3UL, 0x6FA035C3UL, 0x77F2DB5BUL };
+
+    apply_game_random_jump(random, jump);
+}
+
+void long_jump_game_random(game_random *random) {
+    static const unsigned long jump[4] = { 0xB523952EUL, 0x0B6F099FUL, 0xCCF5A0EFUL, 0x1C580662UL };
+
+    apply_game_random_jump(random, jump);
+}
+
+void split_game_random(game_random *random, game_random *child) {
+    *child = *random;
+    long_jump_game_random(random);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file game_random.h
+ * @brief Seedable pseudo-random generator owned by each game.
+ *
+ * The generator is xoshiro128**: four 32-bit words of state, a few shifts
+ * and rotations per number, and jump functions that advance it by 2^64 or
+ * 2^96 numbers at once.
+ *
+ * Streams are handed out in two levels. A game splits a stream off its
+ * generator, with split_game_random(), for each board it builds and each
+ * search it runs, and then goes on 2^96 numbers further. Whoever got the
+ * stream draws from it directly, and gives each of its threads a stream
+ * jump_game_random() steps apart. 2^32 threads fit before the next split,
+ * so no two boards, searches or threads ever draw the same numbers.
+ *
+ * The same seed always gives the same numbers, whatever the platform: the
+ * state words are unsigned long kept to their low 32 bits.
+ */
+
+#ifndef GAME_RANDOM_H
+#define GAME_RANDOM_H
+
+/**
+ * @brief State of a generator.
+ */
+struct game_random {
+    unsigned long seed;         /**< Seed the generator was started from. */
+    unsigned long state[4];     /**< Current state, 32 bits per word. */
+};
+
+typedef struct game_random game_random;
+
+/**
+ * @brief Starts a generator from a seed.
+ *
+ * @param[out] random Pointer to the generator.
+ * @param[in]  seed   Seed; only its low 32 bits are used.
+ */
+void seed_game_random(game_random *random, unsigned long seed);
+
+/**
+ * @brief Draws the next number.
+ *
+ * @param[in,out] random Pointer to the generator.
+ *
+ * @return A number uniformly distributed over 32 bits.
+ */
+unsigned long next_game_random(game_random *random);
+
+/**
+ * @brief Draws a number in a range, without a division.
+ *
+ * @param[in,out] random Pointer to the generator.
+ * @param[in]     start  Lower bound of the range (inclusive).
+ * @param[in]     end    Upper bound of the range (inclusive), less than start + 65536.
+ *
+ * @return A number between @p start and @p end.
+ */
+short next_game_random_range(game_random *random, short start, short end);
+
+/**
+ * @brief Advances the generator by 2^64 numbers.
+ *
+ * @param[in,out] random Pointer to the generator.
+ */
+void jump_game_random(game_random *random);
+
+/**
+ * @brief Advances the generator by 2^96 numbers.
+ *
+ * @param[in,out] random Pointer to the generator.
+ */
+void long_jump_game_random(game_random *random);
+
+/**
+ * @brief Gives a stream of its own to a board or a search.
+ *
+ * @param[in,out] random Pointer to the generator; it goes on 2^96 numbers further.
+ * @param[out]    child  Receives the stream, the generator as it was.
+ */
+void split_game_random(game_random *random, game_random *child);
+
+#endif /* GAME_RANDOM_H */
@@ -0,0 +1,328 @@
+#include"match_index.h"
+#include"field_bitboard.h"
+#include"field_links.h"
+
+#define VECTOR_TYPE unsigned char
+#define VECTOR_NAME match_table
+#define VECTOR_STRUCT_DEFINED
+#include "vector.h"
+
+/* (dx, dy) step of each MATCH_DIRECTION */
+static const int match_directions[MATCH_DIRECTIONS_COUNT][2] = {
+    { 0, 1 }, { -1, 1 }, { 1, 1 }, { 1, 0 }
+};
+
+/* number of bits set in each 4-bit mask */
+static const int mask_bits_count[16] = {
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+
+void init_match_index(game_field *field) {
+    field->matches = match_table_create(0);
+    field->matches_count = 0;
+    field->matches_first = 0;
+}
+
+void free_match_index(game_field *field) {
+    match_table_free(field->matches);
+}
+
+void copy_match_index(game_field *field, game_field *source) {
+    field->matches = match_table_copy(source->matches);
+}
+
+void clear_match_index(game_field *field) {
+    match_table_clear(field->matches);
+    field->matches_count = 0;
+    field->matches_first = 0;
+}
+
+/**
+ * @brief Walks from a cell in a direction (sign 1) or in its reverse (sign -1)
+ *        until an available cell is found.
+ */
+static int walk_available_cell(game_field *field, int index, MATCH_DIRECTION direction, int sign) {
+    field_cell *cells;
+    int res, x, dx, step, count, bounded;
+
+    cells = field->table->items;
+    count = (int) field->table->count;
+
+    dx = match_directions[direction][0] * sign;
+    step = match_directions[direction][1] * sign * field->width + dx;
+    bounded = direction != NEXT_CELL_MATCH_DIRECTION;
+    x = index % field->width;
+
+    res = -1;
+    do {
+        index += step;
+        x += dx;
+
+        if (index < 0 || index >= count || (bounded && (x < 0 || x >= field->width)))
+            index = -1;
+        else if (FIELD_CELL_IS_AVAILABLE(cells[index]))
+            res = index;
+    } while (res == -1 && index != -1);
+
+    return res;
+}
+
+int get_next_available_cell(game_field *field, int index, MATCH_DIRECTION direction) {
+    return walk_available_cell(field, index, direction, 1);
+}
+
+int get_previous_available_cell(game_field *field, int index, MATCH_DIRECTION direction) {
+    return walk_available_cell(field, index, direction, -1);
+}
+
+/**
+ * @brief Stores the mask of a cell, keeping the pair counter and the
+ *        first-pair bound up to date.
+ */
+static void set_match_mask(game_field *field, int index, int mask) {
+    unsigned char *masks;
+
+    masks = field->matches->items;
+
+    field->matches_count += mask_bits_count[mask] - mask_bits_count[masks[index]];
+    masks[index] = (unsigned char) mask;
+
+    if (mask != 0 && index < field->matches_first)
+        field->matches_first = index;
+}
+
+static int compute_match_bit(game_field *field, int index, MATCH_DIRECTION direction) {
+    field_cell *cells;
+    int next;
+
+    cells = field->table->items;
+    next = get_next_linked_cell(field, index, direction);
+
+    return next != -1 && check_field_cell_math(cells + index, cells + next) ? 1 << direction : 0;
+}
+
+static int compute_match_mask(game_field *field, int index) {
+    int res, d;
+
+    res = 0;
+    if (FIELD_CELL_IS_AVAILABLE(field->table->items[index])) {
+        for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+            res |= compute_match_bit(field, index, d);
+        }
+    }
+
+    return res;
+}
+
+static void update_match_bit(game_field *field, int index, MATCH_DIRECTION direction) {
+    int mask;
+
+    mask = field->matches->items[index] & ~(1 << direction);
+    set_match_mask(field, index, mask | compute_match_bit(field, index, direction));
+}
+
+void rebuild_match_index(game_field *field) {
+    field_bitboard *board;
+    unsigned long *starts, word;
+    unsigned char *masks;
+    size_t i;
+    int d, bit, count;
+
+    count = (int) field->table->count;
+
+    clear_match_index(field);
+    match_table_reserve(field->matches, count);
+    if (count > 0)
+        memset(field->matches->items, 0, count);
+    field->matches->count = count;
+
+    /* the bitboard engine gives, per direction, every cell starting a pair */
+    board = create_field_bitboard(field);
+    starts = (unsigned long*) malloc(board->words * sizeof(unsigned long));
+    masks = field->matches->items;
+
+    for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+        get_field_bitboard_starts(board, d, starts);
+
+        for (i = 0; i < board->words; i++) {
+            word = starts[i];
+            field->matches_count += count_bitboard_word_bits(word);
+
+            while (word != 0) {
+                bit = get_bitboard_word_lowest_bit(word);
+                masks[i * BITBOARD_WORD_BITS + bit] |= 1 << d;
+                word &= word - 1;
+            }
+        }
+    }
+
+    free(starts);
+    free_field_bitboard(board);
+}
+
+void update_match_index_cell(game_field *field, int index) {
+    int d, previous;
+
+    set_match_mask(field, index, compute_match_mask(field, index));
+
+    /* the cell that used to see past this one (or that now sees it),
+     * still linked from a cell that was just crossed out */
+    for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+        previous = get_previous_linked_cell(field, index, d);
+
+        if (previous != -1)
+            update_match_bit(field, previous, d);
+    }
+}
+
+void update_match_index_appended(game_field *field, int first) {
+    int i, d, count, previous;
+
+    count = (int) field->table->count;
+
+    /* a field filled from scratch is indexed word by word */
+    if (first == 0) {
+        rebuild_match_index(field);
+    } else {
+        match_table_reserve(field->matches, count);
+        memset(field->matches->items + first, 0, count - first);
+        field->matches->count = count;
+
+        for (i = first; i < count; i++) {
+            set_match_mask(field, i, compute_match_mask(field, i));
+        }
+
+        /* older cells whose walks used to stop at the end of the field */
+        for (i = first; i < count; i++) {
+            for (d = 0; FIELD_CELL_IS_AVAILABLE(field->table->items[i]) && d < MATCH_DIRECTIONS_COUNT; d++) {
+                previous = get_previous_linked_cell(field, i, d);
+
+                if (previous != -1 && previous < first)
+                    update_match_bit(field, previous, d);
+            }
+        }
+    }
+}
+
+void update_match_index_inserted_row(game_field *field, int index) {
+    unsigned char *masks;
+    int i, d, start, inserted, count, cell;
+
+    start = index * field->width;
+    count = (int) field->table->count;
+    inserted = count - (int) field->matches->count;
+
+    match_table_reserve(field->matches, count);
+    masks = field->matches->items;
+    memmove(masks + start + inserted, masks + start, field->matches->count - start);
+    memset(masks + start, 0, inserted);
+    field->matches->count = count;
+
+    if (field->matches_first >= start)
+        field->matches_first += inserted;
+
+    /* diagonals crossing the inserted row now end one column further */
+    for (i = start; i < start + inserted; i++) {
+        for (d = LEFT_DIAGONAL_MATCH_DIRECTION; d <= RIGHT_DIAGONAL_MATCH_DIRECTION; d++) {
+            cell = get_previous_available_cell(field, i, d);
+
+            if (cell != -1)
+                update_match_bit(field, cell, d);
+        }
+    }
+}
+
+void update_match_index_truncated(game_field *field, int first) {
+    int i, d, count, previous;
+
+    count = (int) field->matches->count;
+
+    for (i = first; i < count; i++) {
+        set_match_mask(field, i, 0);
+
+        /* cells paired with a removed cell have nothing after them any more */
+        for (d = 0; d < MATCH_DIRECTIONS_COUNT; d++) {
+            previous = get_previous_linked_cell(field, i, d);
+
+            if (previous != -1 && previous < first && get_next_linked_cell(field, previous, d) == i)
+                set_match_mask(field, previous, field->matches->items[previous] & ~(1 << d));
+        }
+    }
+
+    field->matches->count = first;
+    if (field->matches_first > first)
+        field->matches_first = first;
+}
+
+void update_match_index_removed_row(game_field *field, int index) {
+    int i, d, start, removed, cell;
+
+    start = index * field->width;
+    removed = (int) (field->matches->count - field->table->count);
+
+    for (i = start; i < start + removed; i++) {
+        set_match_mask(field, i, 0);
+    }
+    match_table_remove_range(field->matches, start, removed);
+
+    if (field->matches_first >= start + removed)
+        field->matches_first -= removed;
+    else if (field->matches_first > start)
+        field->matches_first = start;
+
+    /* diagonals reaching the removed row now continue one column further */
+    if (index > 0) {
+        for (i = 0; i < field->width; i++) {
+            for (d = LEFT_DIAGONAL_MATCH_DIRECTION; d <= RIGHT_DIAGONAL_MATCH_DIRECTION; d++) {
+                cell = start - field->width + i;
+
+                if (!FIELD_CELL_IS_AVAILABLE(field->table->items[cell]))
+                    cell = get_previous_available_cell(field, cell, d);
+
+                if (cell != -1)
+                    update_match_bit(field, cell, d);
+            }
+        }
+    }
+}
+
+int get_match_index_pair(game_field *field, int *start, int *end) {
+    unsigned char *masks;
+    unsigned long word;
+    int res, i, d, count, found;
+
+    masks = field->matches->items;
+    count = (int) field->matches->count;
+
+    i = field->matches_first;
+    res = 0;
+
+    if (field->matches_count > 0) {
+
+        /* skip empty masks a machine word at a time */
+        found = 0;
+        while (!found && i + (int) sizeof(unsigned long) <= count) {
+            memcpy(&word, masks + i, sizeof(unsigned long));
+
+            if (word == 0)
+                i += sizeof(unsigned long);
+            else
+                found = 1;
+        }
+
+        while (masks[i] == 0) {
+            i++;
+        }
+
+        for (d = 0; (masks[i] & 1 << d) == 0; d++);
+
+        *start = i;
+        *end = get_next_linked_cell(field, i, d);
+        res = 1;
+    }
+
+    field->matches_first = i;
+
+    return res;
+}
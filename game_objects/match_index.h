@@ -0,0 +1,164 @@
+/**
+ * @file match_index.h
+ * @brief Incremental index of the valid pairs of a NumberMatch game field.
+ *
+ * Every valid pair is seen from its first cell in reading order, looking
+ * forward in one of four directions: down the column, down the left
+ * diagonal, down the right diagonal, or to the next cell in reading order
+ * (same line or next line). For each cell the index stores a small bitmask
+ * of the directions in which the first available cell forms a pair with it.
+ *
+ * The index is updated only around the cells touched by a change, so asking
+ * whether a move exists, or for the first one, no longer rescans the board.
+ */
+
+#ifndef MATCH_INDEX_H
+#define MATCH_INDEX_H
+
+#include"game_field.h"
+
+/**
+ * @brief Directions in which a pair is looked for from its first cell.
+ *
+ * The order is the one in which find_match() tries them.
+ */
+enum MATCH_DIRECTION {
+    COLUMN_MATCH_DIRECTION = 0,         /**< Same column, rows below. */
+    LEFT_DIAGONAL_MATCH_DIRECTION = 1,  /**< Down and to the left. */
+    RIGHT_DIAGONAL_MATCH_DIRECTION = 2, /**< Down and to the right. */
+    NEXT_CELL_MATCH_DIRECTION = 3       /**< Reading order, wrapping to the next line. */
+};
+
+typedef enum MATCH_DIRECTION MATCH_DIRECTION;
+
+/**
+ * @brief Number of values in @ref MATCH_DIRECTION.
+ */
+#define MATCH_DIRECTIONS_COUNT 4
+
+/**
+ * @brief Allocates an empty match index for the field.
+ *
+ * @param[in,out] field Pointer to the game_field whose index is created.
+ */
+void init_match_index(game_field *field);
+
+/**
+ * @brief Frees the match index of the field.
+ *
+ * @param[in,out] field Pointer to the game_field whose index is released.
+ */
+void free_match_index(game_field *field);
+
+/**
+ * @brief Gives a copied field its own copy of the match index.
+ *
+ * @param[in,out] field  Pointer to the copy, sharing the index of @p source.
+ * @param[in]     source Pointer to the original game_field.
+ */
+void copy_match_index(game_field *field, game_field *source);
+
+/**
+ * @brief Empties the match index, keeping its memory.
+ *
+ * @param[in,out] field Pointer to the game_field whose cells were all removed.
+ */
+void clear_match_index(game_field *field);
+
+/**
+ * @brief Recomputes the whole index from the cells of the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ */
+void rebuild_match_index(game_field *field);
+
+/**
+ * @brief Finds the first available cell after a cell in a given direction.
+ *
+ * The cells are walked one by one, which also works from a crossed-out cell;
+ * from an available cell get_next_linked_cell() answers in O(1).
+ *
+ * @param[in] field     Pointer to the game_field.
+ * @param[in] index     Index of the starting cell in reading order.
+ * @param[in] direction Direction of the walk.
+ *
+ * @return Index of the first available cell, or -1 if the walk leaves the field.
+ */
+int get_next_available_cell(game_field *field, int index, MATCH_DIRECTION direction);
+
+/**
+ * @brief Finds the last available cell before a cell in a given direction.
+ *
+ * This is the reverse walk of get_next_available_cell().
+ *
+ * @param[in] field     Pointer to the game_field.
+ * @param[in] index     Index of the starting cell in reading order.
+ * @param[in] direction Direction whose reverse is walked.
+ *
+ * @return Index of the available cell, or -1 if the walk leaves the field.
+ */
+int get_previous_available_cell(game_field *field, int index, MATCH_DIRECTION direction);
+
+/**
+ * @brief Updates the index after the availability of a cell changed.
+ *
+ * Only the pairs starting at the cell and the pairs that used to cross it
+ * (or now end on it) are recomputed.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     index Index of the cell whose availability changed.
+ */
+void update_match_index_cell(game_field *field, int index);
+
+/**
+ * @brief Updates the index after cells were appended to the field.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[in]     first Index of the first appended cell.
+ */
+void update_match_index_appended(game_field *field, int first);
+
+/**
+ * @brief Updates the index after a row without available cells was inserted.
+ *
+ * The reverse of update_match_index_removed_row(), called once the links
+ * are updated.
+ *
+ * @param[in,out] field Pointer to the game_field, already with the row.
+ * @param[in]     index Index of the inserted row.
+ */
+void update_match_index_inserted_row(game_field *field, int index);
+
+/**
+ * @brief Updates the index before the cells from an index to the end are removed.
+ *
+ * Called while the links still reach the removed cells.
+ *
+ * @param[in,out] field Pointer to the game_field, still with the cells.
+ * @param[in]     first Index of the first removed cell.
+ */
+void update_match_index_truncated(game_field *field, int first);
+
+/**
+ * @brief Updates the index after a row without available cells was removed.
+ *
+ * The rows below moved up by one, so only the diagonals crossing the removed
+ * row can connect different cells than before.
+ *
+ * @param[in,out] field Pointer to the game_field, already without the row.
+ * @param[in]     index Index of the removed row.
+ */
+void update_match_index_removed_row(game_field *field, int index);
+
+/**
+ * @brief Returns the first valid pair in the index.
+ *
+ * @param[in,out] field Pointer to the game_field.
+ * @param[out]    start Index of the first cell of the pair.
+ * @param[out]    end   Index of the second cell of the pair.
+ *
+ * @return 1 if a pair exists, 0 otherwise.
+ */
+int get_match_index_pair(game_field *field, int *start, int *end);
+
+#endif /* MATCH_INDEX_H */
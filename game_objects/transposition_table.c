@@ -0,0 +1,66 @@
+#include"transposition_table.h"
+
+
+transposition_table* create_transposition_table(int bits) {
+    transposition_table *res;
+
+    res = (transposition_table*) malloc(sizeof(transposition_table));
+
+    if (res != NULL) {
+        res->mask = (1UL << bits) - 1;
+        res->entries = (transposition_entry*) calloc(res->mask + 1, sizeof(transposition_entry));
+
+        if (res->entries == NULL) {
+            free(res);
+            res = NULL;
+        }
+    }
+
+    return res;
+}
+
+void free_transposition_table(transposition_table *table) {
+    if (table != NULL) {
+        free(table->entries);
+        free(table);
+    }
+}
+
+void clear_transposition_table(transposition_table *table) {
+    unsigned long i;
+
+    for (i = 0; i <= table->mask; i++) {
+        table->entries[i].check = 0;
+        table->entries[i].data = 0;
+    }
+}
+
+int probe_transposition_table(transposition_table *table, unsigned long key, unsigned long *data) {
+    volatile transposition_entry *entry;
+    unsigned long check, value;
+    int res;
+
+    entry = table->entries + (key & table->mask);
+
+    /* both words are read once: a concurrent write makes them disagree */
+    value = entry->data;
+    check = entry->check;
+
+    if ((check ^ value) == key && (check | value) != 0) {
+        *data = value;
+        res = 1;
+    } else {
+        res = 0;
+    }
+
+    return res;
+}
+
+void store_transposition_table(transposition_table *table, unsigned long key, unsigned long data) {
+    volatile transposition_entry *entry;
+
+    entry = table->entries + (key & table->mask);
+
+    entry->data = data;
+    entry->check = key ^ data;
+}
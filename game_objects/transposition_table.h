@@ -0,0 +1,84 @@
+/**
+ * @file transposition_table.h
+ * @brief Fixed-size table of search results keyed by position hashes.
+ *
+ * Many move orders lead to the same field; a search stores what it learned
+ * about a position under its hash (see field_hash.h) and looks it up before
+ * exploring the position again.
+ *
+ * The table is shared by threads without locks: an entry is two words, the
+ * data and the key XORed with the data. A reader accepts an entry only if
+ * the two words agree with the key it looks for, so an entry torn by two
+ * concurrent writes is rejected instead of returning wrong data. A new entry
+ * always replaces the one in its slot.
+ */
+
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include<stdlib.h>
+
+/**
+ * @brief One slot of the table.
+ */
+struct transposition_entry {
+    unsigned long check;    /**< Key XOR data; 0 together with data 0 is an empty slot. */
+    unsigned long data;     /**< Value stored by the search. */
+};
+
+typedef struct transposition_entry transposition_entry;
+
+/**
+ * @brief Transposition table with a power-of-two number of slots.
+ */
+struct transposition_table {
+    transposition_entry *entries;   /**< Slots, indexed by the low bits of the key. */
+    unsigned long mask;             /**< Number of slots minus one. */
+};
+
+typedef struct transposition_table transposition_table;
+
+/**
+ * @brief Allocates an empty table.
+ *
+ * @param[in] bits Base-2 logarithm of the number of slots.
+ *
+ * @return Pointer to the new table, or NULL if the memory is not available.
+ */
+transposition_table* create_transposition_table(int bits);
+
+/**
+ * @brief Frees a table created by create_transposition_table().
+ *
+ * @param[in] table Pointer to the table; NULL is ignored.
+ */
+void free_transposition_table(transposition_table *table);
+
+/**
+ * @brief Empties every slot of the table.
+ *
+ * @param[in,out] table Pointer to the table.
+ */
+void clear_transposition_table(transposition_table *table);
+
+/**
+ * @brief Looks a position up.
+ *
+ * @param[in]  table Pointer to the table.
+ * @param[in]  key   Hash of the position.
+ * @param[out] data  Receives the stored value when the position is found.
+ *
+ * @return 1 if the position is in the table, 0 otherwise.
+ */
+int probe_transposition_table(transposition_table *table, unsigned long key, unsigned long *data);
+
+/**
+ * @brief Stores a value for a position, replacing the slot's previous entry.
+ *
+ * @param[in,out] table Pointer to the table.
+ * @param[in]     key   Hash of the position.
+ * @param[in]     data  Value to store.
+ */
+void store_transposition_table(transposition_table *table, unsigned long key, unsigned long data);
+
+#endif /* TRANSPOSITION_TABLE_H */
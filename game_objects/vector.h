@@ -23,6 +23,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 /**
  * @name Name-Combining and String-Conversion Macros
@@ -205,6 +206,11 @@
  */
 #define VECTOR_expand VECTOR_IMPL(expand)
 
+/** @def VECTOR_reserve
+ *  @brief Ensures the vector can hold a given number of elements.
+ */
+#define VECTOR_reserve VECTOR_IMPL(reserve)
+
 /** @def VECTOR_free     
  *  @brief Frees all vector memory. 
  */
@@ -251,6 +257,21 @@
  */
 #define VECTOR_remove VECTOR_IMPL(remove)
 
+/** @def VECTOR_remove_range
+ *  @brief Removes a contiguous range of elements.
+ */
+#define VECTOR_remove_range VECTOR_IMPL(remove_range)
+
+/** @def VECTOR_clear
+ *  @brief Removes all elements without releasing memory.
+ */
+#define VECTOR_clear VECTOR_IMPL(clear)
+
+/** @def VECTOR_copy
+ *  @brief Creates a new vector holding the same elements.
+ */
+#define VECTOR_copy VECTOR_IMPL(copy)
+
 /** @def VECTOR_foreach  
  *  @brief Iterates through each element in the vector. 
  */
@@ -357,6 +378,56 @@ void VECTOR_expand (VECTOR_NAME* vector) {
     vector->capacity = new_capacity;
 }
 
+/**
+ * @brief Ensures the vector has room for at least @p size elements.
+ *
+ * @param[in,out] vector Pointer to the vector of type VECTOR_NAME*.
+ * @param[in]     size   Minimal number of elements the vector must be able to hold.
+ *
+ * @details
+ * - Does nothing if the current capacity is already large enough.
+ * - Otherwise grows the capacity geometrically (at least doubling it) with a
+ *   single reallocation, so a batch of pushes costs one allocation.
+ */
+void VECTOR_reserve (VECTOR_NAME* vector, size_t size) {
+    size_t new_capacity;
+
+    if (size > vector->capacity) {
+        new_capacity = vector->capacity ? vector->capacity * 2 : 4;
+
+        if (new_capacity < size)
+            new_capacity = size;
+
+        vector->items = (VECTOR_TYPE*) realloc(vector->items, new_capacity * sizeof(VECTOR_TYPE));
+        vector->capacity = new_capacity;
+    }
+}
+
+/**
+ * @brief Creates a copy of a vector.
+ *
+ * @param[in] vector Pointer to the vector to copy.
+ *
+ * @return VECTOR_NAME* Pointer to a new vector holding the same elements,
+ *         allocated with a capacity equal to their number.
+ *
+ * @details
+ * - The elements are copied with a single memcpy, so pointers they hold are
+ *   shared with the original vector.
+ */
+VECTOR_NAME * VECTOR_copy (VECTOR_NAME* vector) {
+    VECTOR_NAME* res;
+
+    res = VECTOR_create(vector->count);
+
+    if (res != NULL && vector->count > 0) {
+        memcpy(res->items, vector->items, vector->count * sizeof(VECTOR_TYPE));
+        res->count = vector->count;
+    }
+
+    return res;
+}
+
 /**
  * @brief Frees all resources used by a dynamic vector.
  * 
@@ -489,7 +560,7 @@ void VECTOR_push (VECTOR_NAME *vector, VECTOR_TYPE value) {
  * 
  * @details 
  * - If the index is greater than the current element count, prints an error and exits.
- * - If the index equals the last element position, behaves like VECTOR_push().
+ * - If the index equals the element count, behaves like VECTOR_push().
  * - Automatically expands the vector if it is full.
  * - Shifts existing elements to the right to make space.
  * - Increments the element count.
@@ -500,7 +571,7 @@ void VECTOR_insert (VECTOR_NAME *vector, VECTOR_TYPE value, size_t index) {
     if (index > vector->count) {
         fprintf(stderr, "Segmentation fault " VECTOR_NAME_STRING " : Error insert in index %ld out of bounds\n", index);
         exit(EXIT_FAILURE);
-    } else if (index == vector->count - 1) {
+    } else if (index == vector->count) {
         VECTOR_push(vector, value);
     } else {
 
@@ -565,6 +636,40 @@ VECTOR_TYPE VECTOR_remove (VECTOR_NAME *vector, size_t index) {
     return res;
 }
 
+/**
+ * @brief Removes a contiguous range of elements from the vector.
+ * 
+ * @param[in,out] vector Pointer to the VECTOR_NAME structure.
+ * @param[in] index      Position of the first element to remove (0-based).
+ * @param[in] count      Number of elements to remove.
+ * 
+ * @details
+ * - If the range exceeds the vector bounds, prints an error message and exits.
+ * - Shifts the tail of the vector with a single memmove().
+ */
+void VECTOR_remove_range (VECTOR_NAME *vector, size_t index, size_t count) {
+
+    if (index > vector->count || count > vector->count - index) {
+        fprintf(stderr, "Segmentation fault " VECTOR_NAME_STRING " : Error remove range %ld out of bounds\n", index);
+        exit(EXIT_FAILURE);
+    }
+
+    if (count > 0) {
+        memmove(vector->items + index, vector->items + index + count,
+                (vector->count - index - count) * sizeof(VECTOR_TYPE));
+        vector->count -= count;
+    }
+}
+
+/**
+ * @brief Removes all elements from the vector, keeping its allocated memory.
+ * 
+ * @param[in,out] vector Pointer to the VECTOR_NAME structure.
+ */
+void VECTOR_clear (VECTOR_NAME *vector) {
+    vector->count = 0;
+}
+
 /**
  * @brief Applies a given function to each element of the vector.
  * 
@@ -691,12 +796,18 @@ void VECTOR_filter (VECTOR_NAME *vector, int (*predicate)(VECTOR_TYPE value)) {
 #undef VECTOR_expand
 #undef VECTOR_create
 #undef VECTOR_free
+#undef VECTOR_reserve
 #undef VECTOR_get
+#undef VECTOR_head
+#undef VECTOR_tail
 #undef VECTOR_set
 #undef VECTOR_push
 #undef VECTOR_insert
 #undef VECTOR_pop
 #undef VECTOR_remove
+#undef VECTOR_remove_range
+#undef VECTOR_clear
+#undef VECTOR_copy
 #undef VECTOR_foreach
 #undef VECTOR_map
 #undef VECTOR_any
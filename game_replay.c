@@ -0,0 +1,327 @@
+#include<string.h>
+
+#include"game_replay.h"
+#include"game_engine.h"
+#include"serializer.h"
+
+/* header of a replay before its first board: magic and version */
+#define REPLAY_HEADER_SIZE 5
+
+/* a record without a board: type and four varints of 5 bytes at most */
+#define REPLAY_RECORD_MAX 21
+
+
+void init_game_replay(game_replay *replay) {
+    replay->recording = 0;
+    replay->file = NULL;
+    replay->data = NULL;
+    replay->size = 0;
+    replay->capacity = 0;
+    replay->commands = 0;
+}
+
+/**
+ * @brief Makes room for @p size more bytes of records.
+ */
+static unsigned char* reserve_game_replay(game_replay *replay, size_t size) {
+    if (replay->capacity < replay->size + size) {
+        replay->capacity = 2 * (replay->size + size);
+        replay->data = (unsigned char*) realloc(replay->data, replay->capacity);
+    }
+
+    return replay->data + replay->size;
+}
+
+static void record_game_replay_varint(game_replay *replay, unsigned long value) {
+    replay->size += write_game_save_varint(value, reserve_game_replay(replay, 5));
+}
+
+static void record_game_replay_position(game_replay *replay, vector2i pos) {
+    record_game_replay_varint(replay, (unsigned long) pos.x);
+    record_game_replay_varint(replay, (unsigned long) pos.y);
+}
+
+/**
+ * @brief Records the size and the save of a field.
+ */
+static void record_game_replay_field(game_replay *replay, game_field *field) {
+    size_t size;
+
+    size = get_game_field_save_size(field);
+
+    record_game_replay_varint(replay, (unsigned long) size);
+    write_game_field_save(field, reserve_game_replay(replay, size));
+    replay->size += size;
+}
+
+int start_game_replay(game_replay *replay, const char *file_name, game_field *field) {
+    replay->size = 0;
+    replay->commands = 0;
+
+    if ((replay->file = fopen(file_name, "w")) == NULL) {
+        printf("Error while serializing game file\nCant write in file: %s\n", file_name);
+    } else {
+        memcpy(reserve_game_replay(replay, REPLAY_HEADER_SIZE), GAME_REPLAY_MAGIC, 4);
+        replay->data[4] = GAME_REPLAY_VERSION;
+        replay->size = REPLAY_HEADER_SIZE;
+
+        record_game_replay_field(replay, field);
+        replay->recording = 1;
+    }
+
+    return replay->recording;
+}
+
+void record_game_replay_command(game_replay *replay, const struct game_command *command,
+                                const struct game_events *events, game_field *field) {
+    const game_event *hint;
+
+    reserve_game_replay(replay, REPLAY_RECORD_MAX);
+
+    switch (command->type) {
+    case GAME_COMMAND_SELECT:
+        replay->data[replay->size++] = GAME_REPLAY_SELECT;
+        record_game_replay_position(replay, command->pos);
+        break;
+    case GAME_COMMAND_EXPAND:
+        replay->data[replay->size++] = GAME_REPLAY_EXPAND;
+        break;
+    case GAME_COMMAND_HINT:
+    case GAME_COMMAND_HINT_PAIR:
+        /* the pair found in a time budget is kept, not the search */
+        if ((hint = find_game_event(events, GAME_EVENT_HINT)) != NULL) {
+            replay->data[replay->size++] = GAME_REPLAY_HINT;
+            record_game_replay_position(replay, hint->start);
+            record_game_replay_position(replay, hint->end);
+        }
+        break;
+    case GAME_COMMAND_NEW_STAGE:
+        replay->data[replay->size++] = GAME_REPLAY_STAGE;
+        record_game_replay_field(replay, field);
+        break;
+    case GAME_COMMAND_UNDO:
+        replay->data[replay->size++] = GAME_REPLAY_UNDO;
+        break;
+    case GAME_COMMAND_REDO:
+        replay->data[replay->size++] = GAME_REPLAY_REDO;
+        break;
+    }
+
+    replay->commands++;
+}
+
+void flush_game_replay(game_replay *replay) {
+    if (replay->recording && replay->size > 0) {
+        if (fwrite(replay->data, 1, replay->size, replay->file) != replay->size || fflush(replay->file) != 0)
+            printf("Error while serializing game file\nCant write replay\n");
+        replay->size = 0;
+    }
+}
+
+void stop_game_replay(game_replay *replay, game_field *field) {
+    unsigned char *hash;
+    unsigned long value;
+    int i;
+
+    if (replay->recording) {
+        reserve_game_replay(replay, REPLAY_RECORD_MAX);
+        replay->data[replay->size++] = GAME_REPLAY_END;
+        record_game_replay_varint(replay, (unsigned long) field->score & 0xFFFFFFFFUL);
+
+        hash = reserve_game_replay(replay, 4);
+        value = field->hash;
+        for (i = 0; i < 4; i++) {
+            hash[i] = (unsigned char) (value >> (8 * i) & 0xFF);
+        }
+        replay->size += 4;
+
+        flush_game_replay(replay);
+        fclose(replay->file);
+        replay->file = NULL;
+        replay->recording = 0;
+    }
+}
+
+void free_game_replay(game_replay *replay) {
+    if (replay->file != NULL)
+        fclose(replay->file);
+
+    free(replay->data);
+    init_game_replay(replay);
+}
+
+/**
+ * @brief Reads a position of a record.
+ */
+static int read_game_replay_position(const unsigned char *data, size_t size, size_t *position, vector2i *pos) {
+    unsigned long x, y;
+    int res;
+
+    res = read_game_save_varint(data, size, position, &x) && read_game_save_varint(data, size, position, &y);
+
+    if (res)
+        *pos = create_vector2i((int) x, (int) y);
+
+    return res;
+}
+
+/**
+ * @brief Reads the size and the save of a field.
+ *
+ * @return The field, or NULL if the record is torn or invalid.
+ */
+static game_field* read_game_replay_field(const unsigned char *data, size_t size, size_t *position) {
+    game_field *res;
+    unsigned long field_size;
+
+    res = NULL;
+
+    if (read_game_save_varint(data, size, position, &field_size) && field_size <= size - *position) {
+        res = deserialize_game_field_data(data + *position, (size_t) field_size);
+        *position += field_size;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Reads the end record: the score and the hash the game ended with.
+ */
+static int read_game_replay_end(const unsigned char *data, size_t size, size_t *position, game_replay_result *result) {
+    unsigned long score;
+    int res, i;
+
+    res = read_game_save_varint(data, size, position, &score) && size - *position >= 4;
+
+    if (res) {
+        result->expected_score = score <= 0x7FFFFFFFUL ? (int) score : -(int) (0xFFFFFFFFUL - score) - 1;
+
+        result->expected_hash = 0;
+        for (i = 0; i < 4; i++) {
+            result->expected_hash |= (unsigned long) data[*position + i] << (8 * i);
+        }
+        *position += 4;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Reads the next record as a command.
+ *
+ * @return 1 if a command was read, 0 at the end of the replay.
+ */
+static int read_game_replay_command(struct game_config *config, const unsigned char *data, size_t size,
+                                    size_t *position, game_command *command, game_replay_result *result) {
+    game_field *board;
+    vector2i pos;
+    int res;
+
+    res = *position < size;
+    pos = create_vector2i(0, 0);
+
+    if (res) {
+        (*position)++;
+
+        switch (data[*position - 1]) {
+        case GAME_REPLAY_SELECT:
+            res = read_game_replay_position(data, size, position, &pos);
+            *command = create_game_command(GAME_COMMAND_SELECT, pos);
+            break;
+        case GAME_REPLAY_EXPAND:
+            *command = create_game_command(GAME_COMMAND_EXPAND, pos);
+            break;
+        case GAME_REPLAY_HINT:
+            *command = create_game_command(GAME_COMMAND_HINT_PAIR, pos);
+            res = read_game_replay_position(data, size, position, &command->pos) &&
+                read_game_replay_position(data, size, position, &command->end);
+            break;
+        case GAME_REPLAY_STAGE:
+            /* the next stage is the recorded board, not one drawn again */
+            board = read_game_replay_field(data, size, position);
+            res = board != NULL;
+            if (res)
+                set_stage_pipeline_board(&config->next_stage, board);
+            *command = create_game_command(GAME_COMMAND_NEW_STAGE, pos);
+            break;
+        case GAME_REPLAY_UNDO:
+            *command = create_game_command(GAME_COMMAND_UNDO, pos);
+            break;
+        case GAME_REPLAY_REDO:
+            *command = create_game_command(GAME_COMMAND_REDO, pos);
+            break;
+        case GAME_REPLAY_END:
+            result->complete = read_game_replay_end(data, size, position, result);
+            res = 0;
+            break;
+        default:
+            res = 0;
+            break;
+        }
+    }
+
+    return res;
+}
+
+int play_game_replay(struct game_config *config, const unsigned char *data, size_t size,
+                     game_replay_step step, game_replay_result *result) {
+    game_field *field;
+    field_journal *journal;
+    game_command command;
+    game_events events;
+    size_t position;
+    int playing;
+
+    result->commands = 0;
+    result->complete = 0;
+    result->diverged = 0;
+    result->expected_score = 0;
+    result->expected_hash = 0;
+
+    position = REPLAY_HEADER_SIZE;
+    field = NULL;
+
+    if (size >= REPLAY_HEADER_SIZE && memcmp(data, GAME_REPLAY_MAGIC, 4) == 0 && data[4] == GAME_REPLAY_VERSION)
+        field = read_game_replay_field(data, size, &position);
+
+    if (field != NULL) {
+        if (config->field != NULL)
+            game_field_free(config->field);
+
+        config->field = field;
+        config->selected_p.x = -1;
+        journal = create_field_journal(FIELD_JOURNAL_DEFAULT_LIMIT);
+        config->field->journal = journal;
+
+        playing = 1;
+        while (playing && read_game_replay_command(config, data, size, &position, &command, result)) {
+            if (apply_game_command(config, &command, &events)) {
+                /* the next board comes from the replay: no board is built in the background */
+                if (command.type == GAME_COMMAND_NEW_STAGE) {
+                    config->field->journal = journal;
+                    clear_field_journal(journal);
+                }
+
+                result->commands++;
+                if (step != NULL)
+                    step(config);
+            } else {
+                result->diverged = 1;
+                playing = 0;
+            }
+        }
+
+        stop_stage_pipeline(&config->next_stage);
+        free_field_journal(journal);
+        config->field->journal = NULL;
+
+        result->score = config->field->score;
+        result->hash = config->field->hash & 0xFFFFFFFFUL;
+    } else {
+        result->score = 0;
+        result->hash = 0;
+    }
+
+    return result->complete && !result->diverged &&
+        result->score == result->expected_score && result->hash == result->expected_hash;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file game_replay.h
+ * @brief Records a game as its first board and the commands played, and plays it again.
+ *
+ * A replay holds what the engine needs to play a game again and nothing
+ * else: the save of the first board, seed and state of the generator
+ * included, then the commands the engine accepted, in order. Playing it
+ * again goes through apply_game_command() like the game did, so that a
+ * replay reproduces a reported game and a set of replays checks that the
+ * rules still give the same results.
+ *
+ * What the engine draws from something else than the generator is
+ * recorded with the command: a hint keeps the pair it showed, found in a
+ * time budget, and a new stage keeps its board, which the board generator
+ * builds in a time limit (see board_generator.h).
+ *
+ * Layout, numbers as varints (see write_game_save_varint()):
+ * - magic GAME_REPLAY_MAGIC (4), version GAME_REPLAY_VERSION (1), size of
+ *   the first board then its save (see write_game_field_save());
+ * - the records, each a GAME_REPLAY_RECORD byte and its payload;
+ * - GAME_REPLAY_END, the score and the hash of the field at the end (the
+ *   low 32 bits, least significant byte first), to verify a replay.
+ *
+ * The records are kept in memory during a stage and written to the file
+ * when the next stage starts and when the game ends: a replay cut by a
+ * crash plays up to the start of its last stage.
+ */
+
+#ifndef GAME_REPLAY_H
+#define GAME_REPLAY_H
+
+#include<stdio.h>
+
+#include"game_objects/game_field.h"
+
+struct game_config;
+struct game_command;
+struct game_events;
+
+/**
+ * @brief First bytes of a replay.
+ */
+#define GAME_REPLAY_MAGIC "NMRP"
+
+/**
+ * @brief Version of the replays written.
+ */
+#define GAME_REPLAY_VERSION 1
+
+/**
+ * @brief First byte of a replay record.
+ */
+enum GAME_REPLAY_RECORD {
+    GAME_REPLAY_SELECT = 'S',   /**< Cell selected: x, y */
+    GAME_REPLAY_EXPAND = 'E',   /**< Addition used */
+    GAME_REPLAY_HINT   = 'H',   /**< Pair highlighted: x, y of both cells */
+    GAME_REPLAY_STAGE  = 'N',   /**< New stage: size of the board, then its save */
+    GAME_REPLAY_UNDO   = 'U',   /**< Move undone */
+    GAME_REPLAY_REDO   = 'R',   /**< Move played again */
+    GAME_REPLAY_END    = 'F'    /**< End of the game: score, hash */
+};
+typedef enum GAME_REPLAY_RECORD GAME_REPLAY_RECORD;
+
+/**
+ * @brief Replay being recorded.
+ */
+struct game_replay {
+    int recording;              /**< 1 while the engine records its commands. */
+    FILE *file;                 /**< File the records go to, or NULL. */
+    unsigned char *data;        /**< Records not written to the file yet. */
+    size_t size;                /**< Size of the records not written yet. */
+    size_t capacity;            /**< Allocated size of @c data. */
+    long commands;              /**< Commands recorded. */
+};
+
+typedef struct game_replay game_replay;
+
+/**
+ * @brief Result of playing a replay again.
+ */
+struct game_replay_result {
+    long commands;                  /**< Commands played. */
+    int complete;                   /**< 1 if the replay reached its end record. */
+    int diverged;                   /**< 1 if the engine refused a recorded command. */
+    int score;                      /**< Score at the end of the replay. */
+    int expected_score;             /**< Score recorded at the end of the game. */
+    unsigned long hash;             /**< Low 32 bits of the hash of the field at the end. */
+    unsigned long expected_hash;    /**< Low 32 bits of the hash recorded. */
+};
+
+typedef struct game_replay_result game_replay_result;
+
+/**
+ * @brief Called after each command played again, to show the game.
+ */
+typedef void (*game_replay_step)(struct game_config *config);
+
+/**
+ * @brief Initializes a replay that does not record.
+ *
+ * @param[out] replay Pointer to the replay.
+ */
+void init_game_replay(game_replay *replay);
+
+/**
+ * @brief Starts recording a game to a file, from the board it starts with.
+ *
+ * @param[in,out] replay    Pointer to a replay that does not record.
+ * @param[in]     file_name File the replay goes to, replaced.
+ * @param[in]     field     Field the game starts with.
+ *
+ * @return int 1 if the file was created and the replay records, 0 otherwise.
+ */
+int start_game_replay(game_replay *replay, const char *file_name, game_field *field);
+
+/**
+ * @brief Records a command the engine accepted, called by apply_game_command().
+ *
+ * @param[in,out] replay  Pointer to a recording replay.
+ * @param[in]     command Pointer to the command.
+ * @param[in]     events  Pointer to its events.
+ * @param[in]     field   Field after the command.
+ */
+void record_game_replay_command(game_replay *replay, const struct game_command *command,
+                                const struct game_events *events, game_field *field);
+
+/**
+ * @brief Writes the records of the replay to its file.
+ *
+ * @param[in,out] replay Pointer to the replay; a replay that does not record is ignored.
+ */
+void flush_game_replay(game_replay *replay);
+
+/**
+ * @brief Records the end of the game, writes the replay and closes its file.
+ *
+ * @param[in,out] replay Pointer to the replay; a replay that does not record is ignored.
+ * @param[in]     field  Field at the end of the game.
+ */
+void stop_game_replay(game_replay *replay, game_field *field);
+
+/**
+ * @brief Closes the file of the replay, if any, and frees its buffer.
+ *
+ * @param[in,out] replay Pointer to the replay; it does not record afterwards.
+ */
+void free_game_replay(game_replay *replay);
+
+/**
+ * @brief Plays a replay again through the engine, as fast as the engine goes.
+ *
+ * The field of the configuration is replaced by the first board of the
+ * replay and stays the field at the end of the replay. The configuration
+ * must not record a replay itself.
+ *
+ * @param[in,out] config Pointer to the game_config the game is played in.
+ * @param[in]     data   Bytes of the replay.
+ * @param[in]     size   Number of bytes.
+ * @param[in]     step   Function called after each command, or NULL.
+ * @param[out]    result Pointer receiving what the replay did.
+ *
+ * @return int 1 if the replay is complete, did not diverge, and ends with
+ *             the score and the hash it recorded; 0 otherwise.
+ */
+int play_game_replay(struct game_config *config, const unsigned char *data, size_t size,
+                     game_replay_step step, game_replay_result *result);
+
+#endif /* GAME_REPLAY_H */
@@ -0,0 +1,311 @@
+#include<math.h>
+#include<time.h>
+#include<pthread.h>
+#include<unistd.h>
+
+#include"hint_search.h"
+
+/* weight of the exploration term of UCB1 */
+#define HINT_EXPLORATION 0.7
+
+/**
+ * @brief A pair of the tree and the statistics of the games that played it.
+ */
+struct hint_node {
+    field_match move;               /* pair leading to this node */
+    struct hint_node *children;     /* pairs playable after it */
+    int children_count;             /* -1 until the node is expanded */
+    long visits;
+    double reward;                  /* sum of the points earned from the move on */
+};
+
+typedef struct hint_node hint_node;
+
+/**
+ * @brief State of one thread, which grows its own tree.
+ */
+struct hint_worker {
+    game_field *field;
+    const hint_options *options;
+    const struct timespec *deadline;
+    pthread_t thread;
+
+    hint_node root;
+    game_random random;
+    double scale;                   /* best reward seen, to bring rewards into [0, 1] */
+    field_match *matches;
+    int capacity;
+};
+
+typedef struct hint_worker hint_worker;
+
+
+void init_hint_options(hint_options *options) {
+    options->threads = 0;
+    options->time_budget = 20;
+    options->playout_depth = 80;
+}
+
+static void free_hint_node(hint_node *node) {
+    int i;
+
+    for (i = 0; i < node->children_count; i++) {
+        free_hint_node(node->children + i);
+    }
+    free(node->children);
+}
+
+static void init_hint_node(hint_node *node) {
+    node->children = NULL;
+    node->children_count = -1;
+    node->visits = 0;
+    node->reward = 0;
+}
+
+static int is_hint_deadline_passed(const struct timespec *deadline) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec > deadline->tv_sec ||
+        (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+/**
+ * @brief Lists the pairs of the field in the worker's buffer.
+ *
+ * @return The number of pairs.
+ */
+static int list_hint_matches(hint_worker *worker, game_field *field) {
+    int res;
+
+    res = find_all_matches(field, NULL, 0);
+
+    if (res > worker->capacity) {
+        worker->capacity = res * 2;
+        worker->matches = (field_match*) realloc(worker->matches, worker->capacity * sizeof(field_match));
+    }
+    find_all_matches(field, worker->matches, res);
+
+    return res;
+}
+
+/**
+ * @brief Plays a pair, counting the stage bonus when it clears the field.
+ */
+static int play_hint_match(game_field *field, const field_match *match) {
+    vector2i start, end;
+    int res;
+
+    start = match->start;
+    end = match->end;
+
+    res = play_game_field_match(field, &start, &end);
+    if (check_game_field_is_clear(field))
+        res += CLEAR_FIELD_MATCH;
+
+    return res;
+}
+
+/**
+ * @brief Plays random moves from a leaf of the tree, the better match type of
+ *        two random pairs each time.
+ *
+ * @return The points earned.
+ */
+static double run_hint_playout(hint_worker *worker, game_field *field) {
+    field_match *first, *second;
+    int res, depth, number, stop;
+
+    res = 0;
+    stop = 0;
+    for (depth = 0; depth < worker->options->playout_depth && !stop; depth++) {
+        number = list_hint_matches(worker, field);
+
+        if (number > 0) {
+            first = worker->matches + next_game_random_range(&worker->random, 0, number - 1);
+            second = worker->matches + next_game_random_range(&worker->random, 0, number - 1);
+            res += play_hint_match(field, second->type > first->type ? second : first);
+            stop = check_game_field_is_clear(field);
+        } else {
+            stop = !duplicate_game_field_cells(field);
+        }
+    }
+
+    return res;
+}
+
+static void expand_hint_node(hint_worker *worker, hint_node *node, game_field *field) {
+    int i;
+
+    node->children_count = list_hint_matches(worker, field);
+    node->children = (hint_node*) malloc((node->children_count + 1) * sizeof(hint_node));
+
+    for (i = 0; i < node->children_count; i++) {
+        init_hint_node(node->children + i);
+        node->children[i].move = worker->matches[i];
+    }
+}
+
+/**
+ * @brief Chooses the child to explore: an unvisited one, else the best UCB1 score.
+ */
+static hint_node* select_hint_child(hint_worker *worker, hint_node *node) {
+    hint_node *res, *child;
+    double score, best, log_visits;
+    int i;
+
+    res = NULL;
+    best = -1;
+    log_visits = log((double) node->visits + 1);
+
+    for (i = 0; i < node->children_count && (res == NULL || res->visits > 0); i++) {
+        child = node->children + i;
+
+        if (child->visits == 0) {
+            res = child;
+        } else {
+            score = child->reward / child->visits / worker->scale +
+                HINT_EXPLORATION * sqrt(log_visits / child->visits);
+            if (score > best) {
+                best = score;
+                res = child;
+            }
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Descends the tree from @p node, expanding it if it was visited before,
+ *        and finishes with a random game.
+ *
+ * @return The points earned from @p node on.
+ */
+static double run_hint_iteration(hint_worker *worker, hint_node *node, game_field *field) {
+    hint_node *child;
+    double res;
+
+    if (check_game_field_is_clear(field)) {
+        res = 0;
+    } else {
+        if (node->children_count < 0 && (node->visits > 0 || node == &worker->root))
+            expand_hint_node(worker, node, field);
+
+        if (node->children_count > 0) {
+            child = select_hint_child(worker, node);
+            res = play_hint_match(field, &child->move);
+            res += run_hint_iteration(worker, child, field);
+
+            child->visits++;
+            child->reward += res;
+        } else {
+            res = run_hint_playout(worker, field);
+        }
+    }
+
+    return res;
+}
+
+static void* run_hint_worker(void *arg) {
+    hint_worker *worker;
+    game_field *field;
+    double reward;
+
+    worker = (hint_worker*) arg;
+
+    /* the root is always expanded, even when the budget is already spent */
+    do {
+        field = copy_game_field(worker->field);
+        reward = run_hint_iteration(worker, &worker->root, field);
+        game_field_free(field);
+
+        worker->root.visits++;
+        if (reward > worker->scale)
+            worker->scale = reward;
+    } while (!is_hint_deadline_passed(worker->deadline));
+
+    return NULL;
+}
+
+int search_game_field_hint(game_field *field, const hint_options *options, vector2i *start_p, vector2i *end_p) {
+    hint_worker *workers;
+    struct timespec deadline;
+    long visits, best_visits;
+    game_random stream;
+    int res, i, j, threads, started, best;
+
+    threads = options->threads;
+    if (threads <= 0)
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+        threads = 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += options->time_budget / 1000;
+    deadline.tv_nsec += options->time_budget % 1000 * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    /* the search takes a stream off the field's generator, and each thread
+     * plays from its own part of that stream */
+    split_game_random(&field->random, &stream);
+
+    workers = (hint_worker*) malloc(threads * sizeof(hint_worker));
+    for (i = 0; i < threads; i++) {
+        workers[i].field = field;
+        workers[i].options = options;
+        workers[i].deadline = &deadline;
+        workers[i].random = i > 0 ? workers[i - 1].random : stream;
+        jump_game_random(&workers[i].random);
+        workers[i].scale = 1;
+        workers[i].matches = NULL;
+        workers[i].capacity = 0;
+        init_hint_node(&workers[i].root);
+    }
+
+    /* the calling thread works as the first worker */
+    started = 1;
+    for (i = 1; started == i && i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, run_hint_worker, workers + i) == 0)
+            started++;
+    }
+
+    run_hint_worker(workers);
+
+    for (i = 1; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    /* every tree lists the pairs of the root in the same order */
+    best = -1;
+    best_visits = -1;
+    for (j = 0; j < workers[0].root.children_count; j++) {
+        visits = 0;
+        for (i = 0; i < started; i++) {
+            visits += workers[i].root.children[j].visits;
+        }
+
+        if (visits > best_visits) {
+            best_visits = visits;
+            best = j;
+        }
+    }
+
+    res = best >= 0;
+    if (res) {
+        *start_p = workers[0].root.children[best].move.start;
+        *end_p = workers[0].root.children[best].move.end;
+    }
+
+    for (i = 0; i < threads; i++) {
+        free_hint_node(&workers[i].root);
+        free(workers[i].matches);
+    }
+    free(workers);
+
+    return res;
+}
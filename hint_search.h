@@ -0,0 +1,61 @@
+/**
+ * @file hint_search.h
+ * @brief Monte Carlo tree search choosing the pair a hint shows.
+ *
+ * The first pair in scan order is often a poor move: it may take a cell a
+ * line clear needed. The search plays many short random games from the
+ * field and keeps, in a tree, how many points each sequence of pairs earned
+ * on average; the pairs leading to the best averages are explored most
+ * (UCB1 selection). Points are counted as user_game_select() counts them,
+ * with CLEAR_FIELD_MATCH for a cleared field. A random game plays the better
+ * of two random pairs at each move, and expands the field when it has no
+ * pair left and some additions.
+ *
+ * The search stops at a wall-clock deadline, short enough to run from an
+ * input loop. Each thread grows its own tree from the same field, and the
+ * visits of the first pairs are summed once every thread stopped: the pair
+ * visited the most is the hint.
+ */
+
+#ifndef HINT_SEARCH_H
+#define HINT_SEARCH_H
+
+#include"game_objects/game_field.h"
+
+/**
+ * @brief Parameters of a hint search.
+ */
+struct hint_options {
+    int threads;        /**< Number of threads; 0 uses every online core. */
+    long time_budget;   /**< Wall-clock time of the search, in milliseconds. */
+    int playout_depth;  /**< Moves of a random game after the tree. */
+};
+
+typedef struct hint_options hint_options;
+
+/**
+ * @brief Fills the options with their default values.
+ *
+ * @param[out] options Pointer to the options to initialize.
+ *
+ * @details
+ * - every online core is used;
+ * - the search lasts 20 ms;
+ * - random games go 80 moves past the tree.
+ */
+void init_hint_options(hint_options *options);
+
+/**
+ * @brief Looks for the pair with the best expected outcome.
+ *
+ * @param[in,out] field   Pointer to the game_field; only its generator moves on,
+ *                        past the stream the search takes.
+ * @param[in]     options Pointer to the search parameters.
+ * @param[out]    start_p Receives the first cell of the pair.
+ * @param[out]    end_p   Receives the second cell of the pair.
+ *
+ * @return int Returns 1 if a pair was found, 0 if the field has none.
+ */
+int search_game_field_hint(game_field *field, const hint_options *options, vector2i *start_p, vector2i *end_p);
+
+#endif /* HINT_SEARCH_H */
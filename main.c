@@ -5,6 +5,8 @@
 #include<unistd.h>
 
 #include"game_config.h"
+#include"serializer.h"
+#include"solver.h"
 
 
 int select_output_function(struct game_config *config, const char *name) {
@@ -16,6 +18,12 @@ int select_output_function(struct game_config *config, const char *name) {
         set_mlv_output(config);
     } else if (strcmp("console", name) == 0) {
         set_console_output(config);
+    } else if (strcmp("bot", name) == 0) {
+        set_bot_output(config);
+    } else if (strcmp("server", name) == 0) {
+        set_server_output(config);
+    } else if (strcmp("replay", name) == 0) {
+        set_replay_output(config);
     } else {
         res = 1;
     }
@@ -23,15 +31,43 @@ int select_output_function(struct game_config *config, const char *name) {
     return res;
 }
 
+int solve_saved_game(const char *file_name, const solver_options *options) {
+    game_field *field;
+    solver_result result;
+    int res;
+
+    if ((field = deserialize_game_field(file_name)) == NULL) {
+        fprintf(stderr, "Error while loading %s\n", file_name);
+        res = 1;
+    } else {
+        solve_game_field(field, options, &result);
+
+        printf("clearable: %s\n", result.clearable ? "yes" : "no");
+        printf("best score: %d\n", result.best_score);
+        printf("positions: %ld%s\n", result.nodes, result.complete ? "" : " (limit reached, partial result)");
+
+        game_field_free(field);
+        res = 0;
+    }
+
+    return res;
+}
+
 int main(int argc, char **argv) {
-    const char *optstring = "ho:";
+    const char *optstring = "ho:s:j:n:p:g:t:d:r:u:m:v:";
+    const char *solve_file;
+    long hint_time;
     int val;
     struct game_config *config;
-    
-    srand(time(NULL));
+    solver_options options;
 
     config = create_game_config();
     set_mlv_output(config);
+    seed_game_random(&config->random, (unsigned long) time(NULL));
+
+    solve_file = NULL;
+    hint_time = -1;
+    init_solver_options(&options);
 
     val = getopt(argc, argv, optstring);
 
@@ -39,7 +75,15 @@ int main(int argc, char **argv) {
 
         switch(val){
         case 'h':
-            printf("numbermatch -o [console | mlv] \"to select output mode\"\n"); 
+            printf("numbermatch -o [console | mlv | bot | server | replay] \"to select output mode\"\n"); 
+            printf("numbermatch -o bot [-p random | greedy | lookahead] [-g games] \"to let a bot play\"\n"); 
+            printf("numbermatch -o server [-u socket] \"to serve games on a Unix socket\"\n"); 
+            printf("numbermatch -o replay [-v speed] [replay.bin ...] \"to play recorded games again and check them\"\n"); 
+            printf("numbermatch -t milliseconds \"to set the time a hint may take, 0 for the first pair\"\n"); 
+            printf("numbermatch -d difficulty \"to play clearable boards, failed by this share of random games (0 to 1)\"\n"); 
+            printf("numbermatch -r seed \"to replay the same boards\"\n"); 
+            printf("numbermatch -m [log | map] \"to log the moves after the save, or write the save in place\"\n"); 
+            printf("numbermatch -s save.bin [-j threads] [-n positions] \"to solve a saved game\"\n"); 
             exit(EXIT_SUCCESS);
             break;
         case 'o': 
@@ -48,6 +92,51 @@ int main(int argc, char **argv) {
                 exit(EXIT_FAILURE);
             }
             break;
+        case 's':
+            solve_file = optarg;
+            break;
+        case 'j':
+            options.threads = atoi(optarg);
+            break;
+        case 'n':
+            options.max_nodes = atol(optarg);
+            break;
+        case 'p':
+            if (set_bot_policy(optarg)) {
+                fprintf(stderr, "Unknown bot policy %s\n", optarg); 
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'g':
+            set_bot_games(atol(optarg));
+            break;
+        case 'u':
+            set_server_path(optarg);
+            break;
+        case 'v':
+            set_replay_speed(atof(optarg));
+            break;
+        case 't':
+            hint_time = atol(optarg);
+            break;
+        case 'm':
+            if (strcmp(optarg, "log") == 0) {
+                config->save_mode = SAVE_MODE_LOG;
+            } else if (strcmp(optarg, "map") == 0) {
+                config->save_mode = SAVE_MODE_MAP;
+            } else {
+                fprintf(stderr, "Unknown save mode %s\n", optarg); 
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'r':
+            seed_game_random(&config->random, strtoul(optarg, NULL, 10));
+            break;
+        case 'd':
+            config->solvable_boards = 1;
+            config->generator.difficulty = atof(optarg);
+            config->generator.tolerance = 0.1;
+            break;
         case ':': 
             fprintf(stderr, "Argument missing for option %c\n", optopt);
             exit(EXIT_FAILURE);
@@ -61,6 +150,18 @@ int main(int argc, char **argv) {
         val=getopt(argc, argv, optstring);
     }
 
+    set_replay_files(argv + optind, argc - optind);
+
+    /* a given hint time wins over the one of the output mode, whatever their order */
+    if (hint_time >= 0)
+        config->hint_time = hint_time;
+
+    if (solve_file != NULL) {
+        val = solve_saved_game(solve_file, &options);
+        free_game_config(config);
+        exit(val ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
     execute_game(config);
 
     free_game_config(config);
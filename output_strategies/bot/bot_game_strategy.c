@@ -0,0 +1,265 @@
+#include <signal.h>
+#include <time.h>
+
+#include "bot_game_strategy.h"
+
+/**
+ * @brief Settings and results of the games played by the bot.
+ */
+struct bot_state {
+    bot_policy policy;
+    long games;
+
+    long played;
+    long total_score;
+    long total_stage;
+    int best_score;
+};
+
+static struct bot_state bot = { choose_greedy_bot_move, BOT_DEFAULT_GAMES, 0, 0, 0, 0 };
+
+static volatile sig_atomic_t bot_interrupted = 0;
+
+
+static void interrupt_bot(int signal_number) {
+    (void) signal_number;
+    bot_interrupted = 1;
+}
+
+/**
+ * @brief Points a pair earns, counting the stage bonus when it clears the field.
+ */
+static int play_bot_match(game_field *field, const field_match *match) {
+    vector2i start, end;
+    int res;
+
+    /* the positions are moved when rows are removed, the pair is kept as is */
+    start = match->start;
+    end = match->end;
+
+    res = play_game_field_match(field, &start, &end);
+    if (check_game_field_is_clear(field))
+        res += CLEAR_FIELD_MATCH;
+
+    return res;
+}
+
+/**
+ * @brief Finds the pair earning the most points over the next @p depth moves.
+ *
+ * @param field Pointer to the game_field structure.
+ * @param depth Number of moves to look at, 1 or more.
+ * @param best Receives the pair, if there is one; may be NULL.
+ *
+ * @return The points earned, or -1 if the field has no pair.
+ */
+static int find_best_bot_match(game_field *field, int depth, field_match *best) {
+    field_match *matches;
+    game_field *child;
+    int res, i, number, gain, next;
+
+    number = find_all_matches(field, NULL, 0);
+    matches = (field_match*) malloc((number + 1) * sizeof(field_match));
+    find_all_matches(field, matches, number);
+
+    res = -1;
+    for (i = 0; i < number; i++) {
+        child = copy_game_field(field);
+        gain = play_bot_match(child, &matches[i]);
+
+        if (depth > 1 && !check_game_field_is_clear(child)) {
+            next = find_best_bot_match(child, depth - 1, NULL);
+            if (next > 0)
+                gain += next;
+        }
+        game_field_free(child);
+
+        if (gain > res) {
+            res = gain;
+            if (best != NULL)
+                *best = matches[i];
+        }
+    }
+
+    free(matches);
+
+    return res;
+}
+
+/**
+ * @brief Turns the result of a search into a move, expanding when no pair is left.
+ */
+static void set_bot_match_move(bot_move *move, int found, field_match *match) {
+    if (found) {
+        move->action = BOT_MATCH;
+        move->start = match->start;
+        move->end = match->end;
+    } else {
+        move->action = BOT_EXPAND;
+    }
+}
+
+void choose_random_bot_move(game_field *field, bot_move *move) {
+    field_match *matches;
+    int number;
+
+    number = find_all_matches(field, NULL, 0);
+
+    if (number > 0 && field->hints_available > 0) {
+        move->action = BOT_HINT;
+    } else {
+        matches = (field_match*) malloc((number + 1) * sizeof(field_match));
+        find_all_matches(field, matches, number);
+
+        set_bot_match_move(move, number > 0, matches + (number > 0 ? next_game_random_range(&field->random, 0, number - 1) : 0));
+
+        free(matches);
+    }
+}
+
+void choose_greedy_bot_move(game_field *field, bot_move *move) {
+    field_match match;
+
+    set_bot_match_move(move, find_best_bot_match(field, 1, &match) >= 0, &match);
+}
+
+void choose_lookahead_bot_move(game_field *field, bot_move *move) {
+    field_match match;
+
+    set_bot_match_move(move, find_best_bot_match(field, 2, &match) >= 0, &match);
+}
+
+int set_bot_policy(const char *name) {
+    int res;
+
+    res = 0;
+    if (strcmp("random", name) == 0) {
+        bot.policy = choose_random_bot_move;
+    } else if (strcmp("greedy", name) == 0) {
+        bot.policy = choose_greedy_bot_move;
+    } else if (strcmp("lookahead", name) == 0) {
+        bot.policy = choose_lookahead_bot_move;
+    } else {
+        res = 1;
+    }
+
+    return res;
+}
+
+void set_bot_games(long games) {
+    bot.games = games > 0 ? games : BOT_DEFAULT_GAMES;
+}
+
+void display_bot_game_screen(struct game_config *config) {
+    (void) config;
+}
+
+/**
+ * @brief Plays a pair the way a player would: two selections.
+ */
+static void select_bot_pair(struct game_config *config, vector2i start, vector2i end) {
+    game_command command;
+    game_events events;
+
+    command = create_game_command(GAME_COMMAND_SELECT, start);
+    apply_game_command(config, &command, &events);
+
+    command.pos = end;
+    apply_game_command(config, &command, &events);
+}
+
+void user_bot_game_input(struct game_config *config) {
+    bot_move move;
+    game_command command;
+    game_events events;
+    const game_event *hint;
+
+    if (bot_interrupted) {
+        config->exit = 1;
+    } else {
+        bot.policy(config->field, &move);
+
+        switch (move.action) {
+        case BOT_MATCH:
+            select_bot_pair(config, move.start, move.end);
+            break;
+        case BOT_EXPAND:
+            command = create_game_command(GAME_COMMAND_EXPAND, move.start);
+            apply_game_command(config, &command, &events);
+            break;
+        case BOT_HINT:
+            command = create_game_command(GAME_COMMAND_HINT, move.start);
+            apply_game_command(config, &command, &events);
+
+            if ((hint = find_game_event(&events, GAME_EVENT_HINT)) != NULL) {
+                set_highlight_game_field_cell(config->field, hint->start, 0);
+                set_highlight_game_field_cell(config->field, hint->end, 0);
+                select_bot_pair(config, hint->start, hint->end);
+            }
+            break;
+        }
+    }
+}
+
+void end_bot_game_message(struct game_config *config) {
+    bot.played++;
+    bot.total_score += config->field->score;
+    bot.total_stage += config->field->stage;
+    if (config->field->score > bot.best_score)
+        bot.best_score = config->field->score;
+}
+
+/**
+ * @brief Seconds elapsed since @p start.
+ */
+static double get_bot_elapsed_time(const struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void show_bot_game_menu(struct game_config *config) {
+    struct sigaction action, previous;
+    struct timespec start;
+    double elapsed;
+    long i;
+
+    config->autosave = 0;
+
+    bot.played = 0;
+    bot.total_score = 0;
+    bot.total_stage = 0;
+    bot.best_score = 0;
+    bot_interrupted = 0;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = interrupt_bot;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &previous);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < bot.games && !bot_interrupted; i++) {
+        start_game(config);
+    }
+
+    elapsed = get_bot_elapsed_time(&start);
+
+    sigaction(SIGINT, &previous, NULL);
+
+    printf("seed: %lu\n", config->random.seed);
+    printf("games: %ld%s\n", bot.played, bot_interrupted ? " (interrupted)" : "");
+    printf("time: %.3f s\n", elapsed);
+    printf("games per second: %.1f\n", elapsed > 0 ? bot.played / elapsed : 0.0);
+    if (bot.played > 0) {
+        printf("average score: %.1f\n", (double) bot.total_score / bot.played);
+        printf("best score: %d\n", bot.best_score);
+        printf("average stage: %.2f\n", (double) bot.total_stage / bot.played);
+    }
+}
+
+void show_bot_game_message(const char *text) {
+    (void) text;
+}
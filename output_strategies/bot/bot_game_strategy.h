@@ -0,0 +1,125 @@
+/**
+ * @file bot_game_strategy.h
+ * @brief Headless output strategy where a bot plays the NumberMatch game.
+ *
+ * This module implements the `output_config` interface without rendering
+ * anything and without waiting: instead of reading keys, the update step asks
+ * a policy for the next action and plays it as commands of the engine
+ * (game_engine.h), the rules a human player goes through.
+ * The menu plays a number of games in a row and reports statistics and the
+ * number of games per second when it exits.
+ *
+ * Bot games never touch "save.bin" or "scores.bin", and their hints show the
+ * first pair unless a hint time is given with -t.
+ */
+
+#ifndef _BOT_GAME_STRATEGY_H
+#define _BOT_GAME_STRATEGY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../game.h"
+#include "../../game_config.h"
+#include "../output_config.h"
+
+/**
+ * @brief Number of games played when no other number is requested.
+ */
+#define BOT_DEFAULT_GAMES 1000
+
+/**
+ * @enum BOT_ACTION
+ * @brief Actions a bot policy can choose.
+ */
+enum BOT_ACTION {
+    BOT_MATCH  = 0,     /**< Select the pair start / end */
+    BOT_EXPAND = 1,     /**< Duplicate the available cells */
+    BOT_HINT   = 2      /**< Ask for a hint and play the highlighted pair */
+};
+typedef enum BOT_ACTION BOT_ACTION;
+
+/**
+ * @brief Move chosen by a bot policy.
+ */
+struct bot_move {
+    BOT_ACTION action;  /**< What to do */
+    vector2i start;     /**< First cell of the pair, for BOT_MATCH */
+    vector2i end;       /**< Second cell of the pair, for BOT_MATCH */
+};
+typedef struct bot_move bot_move;
+
+/**
+ * @brief A policy chooses the next move of a game that is not over.
+ */
+typedef void (*bot_policy)(game_field *field, bot_move *move);
+
+/**
+ * @brief Plays the hinted pair while hints remain, then a random pair.
+ * @param field Pointer to the game_field structure.
+ * @param move Receives the chosen move.
+ */
+void choose_random_bot_move(game_field *field, bot_move *move);
+
+/**
+ * @brief Plays the pair earning the most points right away.
+ * @param field Pointer to the game_field structure.
+ * @param move Receives the chosen move.
+ */
+void choose_greedy_bot_move(game_field *field, bot_move *move);
+
+/**
+ * @brief Plays the pair earning the most points over this move and the next one.
+ * @param field Pointer to the game_field structure.
+ * @param move Receives the chosen move.
+ */
+void choose_lookahead_bot_move(game_field *field, bot_move *move);
+
+/**
+ * @brief Selects the policy used by the bot.
+ * @param name "random", "greedy" or "lookahead".
+ * @return 0 on success, 1 if the name is unknown.
+ */
+int set_bot_policy(const char *name);
+
+/**
+ * @brief Sets the number of games the bot plays.
+ * @param games Number of games, BOT_DEFAULT_GAMES if not positive.
+ */
+void set_bot_games(long games);
+
+/**
+ * @brief Does nothing: the bot does not render the game.
+ * @param config Pointer to the game_config structure.
+ */
+void display_bot_game_screen(struct game_config *config);
+
+/**
+ * @brief Plays the move chosen by the policy.
+ * @param config Pointer to the game_config structure.
+ */
+void user_bot_game_input(struct game_config *config);
+
+/**
+ * @brief Records the result of a finished game.
+ * @param config Pointer to the game_config structure.
+ */
+void end_bot_game_message(struct game_config *config);
+
+/**
+ * @brief Plays the requested number of games and prints the statistics.
+ *
+ * An interrupt (Ctrl-C) abandons the current game and still prints them.
+ *
+ * @param config Pointer to the game_config structure.
+ */
+void show_bot_game_menu(struct game_config *config);
+
+/**
+ * @brief Ignores the message: nobody reads it.
+ * @param text Message string.
+ */
+void show_bot_game_message(const char *text);
+
+#endif /* _BOT_GAME_STRATEGY_H */
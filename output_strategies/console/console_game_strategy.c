@@ -27,7 +27,7 @@ GAME_KEY get_game_key() {
 
     key = get_key();
     switch(key) {
-    case ENTER: case HELP: case ADD_LINE:
+    case ENTER: case HELP: case ADD_LINE: case UNDO: case REDO:
         res = key;
         break;
     case 27:
@@ -97,7 +97,7 @@ void user_console_game_input(struct game_config *config) {
     
     key = get_game_key();
 
-    if (key & ARROW_KEY) {
+    if (key > ARROW_KEY && key <= RIGHT) {
         user_console_game_move(key, &config->cursor_p, config->field);
     } else {
         switch (key) {
@@ -110,6 +110,12 @@ void user_console_game_input(struct game_config *config) {
         case HELP:
             show_game_hints(config);
             break;
+        case UNDO:
+            undo_game_move(config);
+            break;
+        case REDO:
+            redo_game_move(config);
+            break;
         default:
             break;
         }
@@ -120,19 +126,15 @@ void user_console_game_input(struct game_config *config) {
 
 void display_console_available_numbers(game_field *field) {
     int i, numbers[10];
-    vector2i pos;
-    field_cell *cell;
+    field_cell *cells;
     
     for (i = 1; i < 10; i++)
         numbers[i] = 0;
 
+    cells = field->table->items;
     for (i = 0; i < field->count; i++) {
-        pos.x = i % field->width;
-        pos.y = i / field->width;
-
-        cell = get_game_field_cell(field, pos);
-        if (cell->is_available)
-            numbers[cell->value] = 1;
+        if (FIELD_CELL_IS_AVAILABLE(cells[i]))
+            numbers[FIELD_CELL_VALUE(cells[i])] = 1;
     }
 
     for (i = 1; i < 10; i++) {
@@ -146,34 +148,39 @@ void display_console_available_numbers(game_field *field) {
 
 void print_field_cell(field_cell *cell) {
     const char *color;
+    int value;
 
-    if (!cell->is_available)
+    if (!FIELD_CELL_IS_AVAILABLE(*cell))
         color = UNENABLE_COLOR;
-    else if (cell->is_highlited)
+    else if (FIELD_CELL_IS_HIGHLITED(*cell))
         color = HIGHLITED_COLOR;
     else
         color = ENABLE_COLOR;
 
-    if (cell->is_selected && cell->is_cursor)
-        printf(SELECTED_CURSOR_PRINT, color, cell->value);
-    else if (cell->is_selected)
-        printf(SELECTED_PRINT, color, cell->value);
-    else if (cell->is_cursor)
-        printf(CURSOR_PRINT, color, cell->value);
+    value = FIELD_CELL_VALUE(*cell);
+
+    if (FIELD_CELL_IS_SELECTED(*cell) && FIELD_CELL_IS_CURSOR(*cell))
+        printf(SELECTED_CURSOR_PRINT, color, value);
+    else if (FIELD_CELL_IS_SELECTED(*cell))
+        printf(SELECTED_PRINT, color, value);
+    else if (FIELD_CELL_IS_CURSOR(*cell))
+        printf(CURSOR_PRINT, color, value);
     else
-        printf(BASE_PRINT, color, cell->value);
+        printf(BASE_PRINT, color, value);
 }
 
 
 void print_game_field(game_field *field) {
     int i, j, row_size;
+    field_cell *row;
 
     for(i = 0; i < get_game_field_height(field); i++) {
+        row = get_game_field_row(field, i);
         row_size = get_game_field_row_size(field, i);
         
         for(j = 0; j < row_size; j++) {
 
-            print_field_cell(get_game_field_cell(field, create_vector2i(j, i)));
+            print_field_cell(row + j);
         }
 
         printf("\n");
@@ -197,6 +204,7 @@ void display_console_game_screen(struct game_config *config) {
            field->hints_available, field->hints_max);
     printf("Additions ( %c ) | %d / %d\n", ADD_LINE + ('A' - 'a'),
            field->additions_available, field->additions_max);
+    printf("Undo ( %c ) | Redo ( %c )\n", UNDO + ('A' - 'a'), REDO + ('A' - 'a'));
     
     for (i = 0; i < field->width; i++)
         printf(HORISONTAL_LINE_PATTERN);
@@ -310,10 +318,10 @@ void show_console_game_menu(struct game_config *config) {
     const int n = 4;
     int sel = 0;
     GAME_KEY key;
-    int i, best_score;
+    int i, best_score, today_score;
     int exit = 0;
 
-    best_score = deserialize_game_score("score.bin");
+    load_score_board(&config->scores, "scores.bin");
 
     while (!exit) {
         if (system("clear") != 0)
@@ -333,7 +341,9 @@ void show_console_game_menu(struct game_config *config) {
         printf("\n          ╚═╝     ╚═╝╚═╝  ╚═╝   ╚═╝    ╚═════╝╚═╝  ╚═╝");
         printf("\n================================================================");
 
-        printf("\n  Best score: %d\n", best_score);
+        best_score = get_score_board_best(&config->scores, SCORE_BOARD_ALL_TIME);
+        today_score = get_score_board_best(&config->scores, SCORE_BOARD_TODAY);
+        printf("\n  Best score: %d    Today: %d\n", best_score, today_score);
 
         for (i = 0; i < n; i++) {
             if (i == sel) printf("\n >%s<", items[i]);
@@ -354,7 +364,6 @@ void show_console_game_menu(struct game_config *config) {
             break;
         case ENTER:
             execute_cosnole_game_action(config, sel, &exit);
-            best_score = deserialize_game_score("score.bin");
             break;
         default:
             break;
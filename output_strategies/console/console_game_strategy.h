@@ -47,6 +47,8 @@ enum GAME_KEY {
     ENTER     = 10,             /**< Enter key */
     HELP      = 104,            /**< 'H' key for help */
     ADD_LINE  = 97,             /**< 'A' key to add a line */
+    UNDO      = 117,            /**< 'U' key to undo the last move */
+    REDO      = 114,            /**< 'R' key to redo an undone move */
     NONE      = 0               /**< Unrecognized key */
 };
 typedef enum GAME_KEY GAME_KEY;
@@ -30,17 +30,17 @@ void select_cell_style(field_cell *cell,
     *font_color = MLV_COLOR_BLACK;
     *background_color = MLV_COLOR_WHITE;
 
-    if (!cell->is_available) {
+    if (!FIELD_CELL_IS_AVAILABLE(*cell)) {
         *font_color = MLV_COLOR_DARK_GRAY;
         *background_color = MLV_COLOR_LIGHT_GRAY;
     } else {
-        if (cell->is_selected) {
+        if (FIELD_CELL_IS_SELECTED(*cell)) {
             *font_color = MLV_COLOR_DEEPSKYBLUE;
             *background_color = MLV_rgba(146, 225, 255, 255);
-        } else if (cell->is_cursor) {
+        } else if (FIELD_CELL_IS_CURSOR(*cell)) {
             *background_color = MLV_rgba(200, 225, 255, 255);
         }
-        if (cell->is_highlited) {
+        if (FIELD_CELL_IS_HIGHLITED(*cell)) {
             *font_color = MLV_COLOR_YELLOW;
         }
     }
@@ -48,8 +48,9 @@ void select_cell_style(field_cell *cell,
 
 void display_game_grid(game_field *field, int shift) {
     char text[2] = " ";
-    int i, j, field_row;
-    vector2i field_cell_p, cell_index;
+    int i, j, row_size;
+    vector2i field_cell_p;
+    field_cell *row;
     MLV_Font *font = MLV_load_font(GAME_FONT_BOLD, 22);
     MLV_Color background_color, font_color;
 
@@ -57,14 +58,13 @@ void display_game_grid(game_field *field, int shift) {
     
     for (j = 0; j < get_game_field_height(field); j++) {
 
-        field_row = get_game_field_row_size(field, j);
-        for (i = 0; i < field_row; i++) {
+        row = get_game_field_row(field, j);
+        row_size = get_game_field_row_size(field, j);
+        for (i = 0; i < row_size; i++) {
 
-            cell_index = create_vector2i(i, j);
+            text[0] = '0' + FIELD_CELL_VALUE(row[i]);
 
-            text[0] = '0' + get_game_field_cell(field, cell_index)->value;
-
-            select_cell_style(get_game_field_cell(field, cell_index), &font_color, &background_color);
+            select_cell_style(row + i, &font_color, &background_color);
                 
             MLV_draw_text_box_with_font(field_cell_p.x, field_cell_p.y, CELL_SIZE, CELL_SIZE,
                                         text, font,
@@ -269,6 +269,8 @@ void user_mlv_game_input(struct game_config* config) {
     MATCH_TYPE user_match;
     
     MLV_Event event;
+    MLV_Keyboard_button key_sym;
+    MLV_Button_state key_state;
     MLV_Button_state curr_state;
     MLV_Button exit_btn;
 
@@ -280,10 +282,10 @@ void user_mlv_game_input(struct game_config* config) {
 
     field_height = get_game_field_height(config->field);
 
-    event = MLV_get_event(NULL, NULL, NULL,
+    event = MLV_get_event(&key_sym, NULL, NULL,
                           NULL, NULL,
                           &x, &y, NULL,
-                          NULL);
+                          &key_state);
 
     /* update mouse position */
     if (event == MLV_MOUSE_MOTION) {
@@ -291,6 +293,14 @@ void user_mlv_game_input(struct game_config* config) {
         mouse_p.y = y;
     }
 
+    /* 'u' undoes the last move, 'r' plays it again */
+    if (event == MLV_KEY && key_state == MLV_PRESSED) {
+        if (key_sym == MLV_KEYBOARD_u)
+            undo_game_move(config);
+        else if (key_sym == MLV_KEYBOARD_r)
+            redo_game_move(config);
+    }
+
     /* get grid cursor position */
     gridPos = create_vector2i(
         (x - GAME_PADDING) / CELL_SIZE,
@@ -886,6 +886,20 @@ int confirm_new_game(void){
  *                                 MAIN MENU
  * ==========================================================================*/
 
+/* Best scores of all time and of the day, from the scores kept in memory */
+static void update_menu_scores(struct game_config *config, int *best_score, char *score_text,
+                               int *today_score, char *today_text) {
+    load_score_board(&config->scores, "scores.bin");
+
+    *best_score = get_score_board_best(&config->scores, SCORE_BOARD_ALL_TIME);
+    strcpy(score_text, "best score: ");
+    itos(score_text + 12, *best_score, 8);
+
+    *today_score = get_score_board_best(&config->scores, SCORE_BOARD_TODAY);
+    strcpy(today_text, "today: ");
+    itos(today_text + 7, *today_score, 8);
+}
+
 void mlv_show_menu(struct game_config *config){
     FILE *file;
 
@@ -915,10 +929,10 @@ void mlv_show_menu(struct game_config *config){
 
     int best_score;
     char score_text[20];
+    int today_score;
+    char today_text[20];
 
-    best_score = deserialize_game_score("score.bin");
-    strcpy(score_text, "best score: ");
-    itos(score_text + 12, best_score, 8);
+    update_menu_scores(config, &best_score, score_text, &today_score, today_text);
 
     MLV_create_window("NumberMatch Menu", "NumberMatch",
                       GAME_WINDOW_WIDTCH, GAME_WINDOW_HEIGHT);
@@ -966,6 +980,11 @@ void mlv_show_menu(struct game_config *config){
                           GAME_WINDOW_HEIGHT/6 + 50, 
                           score_text, MLV_COLOR_WHITE);
 
+        if (today_score > 0)
+            MLV_draw_text(GAME_WINDOW_WIDTCH/2 - 63,
+                          GAME_WINDOW_HEIGHT/6 + 70,
+                          today_text, MLV_COLOR_WHITE);
+
         bx_center = (GAME_WINDOW_WIDTCH - BTN_W) / 2;
         bx = bx_center;
 
@@ -1006,17 +1025,13 @@ void mlv_show_menu(struct game_config *config){
                 }
 
                 /* update best score text */
-                best_score = deserialize_game_score("score.bin");
-                strcpy(score_text, "best score: ");
-                itos(score_text + 12, best_score, 8);
+                update_menu_scores(config, &best_score, score_text, &today_score, today_text);
             }
             else if (hit_button(mx,my,bx,load_y)) {
                 load_game(config);
 
                 /* update best score text */
-                best_score = deserialize_game_score("score.bin");
-                strcpy(score_text, "best score: ");
-                itos(score_text + 12, best_score, 8);
+                update_menu_scores(config, &best_score, score_text, &today_score, today_text);
             }
             else if (hit_button(mx,my,bx,tut_y)) {
                 show_tutorial_screen();
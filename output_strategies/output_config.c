@@ -30,4 +30,52 @@ void set_mlv_output(struct game_config *config) {
     config->output->end_game_message = mlv_end_game_message;
     config->output->show_game_menu = mlv_show_menu;
     config->output->show_game_message = MLV_show_ok_game_message;
-}
\ No newline at end of file
+}
+
+
+void set_bot_output(struct game_config *config) {
+
+    if (config->output != NULL) {
+        free(config->output);
+    }
+    config->output = (struct output_config*)malloc(sizeof(struct output_config));
+
+    config->output->display_game = display_bot_game_screen;
+    config->output->update_game = user_bot_game_input;
+    config->output->end_game_message = end_bot_game_message;
+    config->output->show_game_menu = show_bot_game_menu;
+    config->output->show_game_message = show_bot_game_message;
+
+    /* a hint shows the first pair, as fast as the other moves; -t still asks for a search */
+    config->hint_time = 0;
+}
+
+
+void set_server_output(struct game_config *config) {
+
+    if (config->output != NULL) {
+        free(config->output);
+    }
+    config->output = (struct output_config*)malloc(sizeof(struct output_config));
+
+    config->output->display_game = display_server_game_screen;
+    config->output->update_game = user_server_game_input;
+    config->output->end_game_message = end_server_game_message;
+    config->output->show_game_menu = show_server_game_menu;
+    config->output->show_game_message = show_server_game_message;
+}
+
+
+void set_replay_output(struct game_config *config) {
+
+    if (config->output != NULL) {
+        free(config->output);
+    }
+    config->output = (struct output_config*)malloc(sizeof(struct output_config));
+
+    config->output->display_game = display_replay_game_screen;
+    config->output->update_game = user_replay_game_input;
+    config->output->end_game_message = end_replay_game_message;
+    config->output->show_game_menu = show_replay_game_menu;
+    config->output->show_game_message = show_replay_game_message;
+}
@@ -4,7 +4,7 @@
  *
  * This module defines the `output_config` structure, which stores function pointers
  * used to render the game, update it based on user input, display messages, and 
- * handle end-game screens. Different output implementations (Console, MLV, etc.)
+ * handle end-game screens. Different output implementations (Console, MLV, bot, server, replay)
  * populate this structure with their respective strategy functions.
  */
 
@@ -18,6 +18,9 @@ struct output_config;
 
 #include "console/console_game_strategy.h"
 #include "mlv/mlv_game_strategy.h"
+#include "bot/bot_game_strategy.h"
+#include "server/server_game_strategy.h"
+#include "replay/replay_game_strategy.h"
 
 /**
  * @brief Defines a strategy interface for rendering and interacting with the game.
@@ -60,4 +63,35 @@ void set_console_output(struct game_config *config);
  */
 void set_mlv_output(struct game_config *config);
 
+/**
+ * @brief Applies the headless bot strategy.
+ *
+ * This function sets the output function pointers to the bot implementation, which
+ * plays games with a policy instead of a human and renders nothing. Hints
+ * show the first pair: `hint_time` is set to 0.
+ *
+ * @param[out] config Pointer to the game configuration whose `output` field will be updated.
+ */
+void set_bot_output(struct game_config *config);
+
+/**
+ * @brief Applies the session server strategy.
+ *
+ * This function sets the output function pointers to the server implementation,
+ * which serves games to clients over a Unix socket and renders nothing.
+ *
+ * @param[out] config Pointer to the game configuration whose `output` field will be updated.
+ */
+void set_server_output(struct game_config *config);
+
+/**
+ * @brief Applies the replay strategy.
+ *
+ * This function sets the output function pointers to the replay implementation,
+ * which plays recorded games again and checks their results.
+ *
+ * @param[out] config Pointer to the game configuration whose `output` field will be updated.
+ */
+void set_replay_output(struct game_config *config);
+
 #endif /* _OUTPUT_CONFIG_H */
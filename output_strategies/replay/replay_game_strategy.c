@@ -0,0 +1,146 @@
+#include <time.h>
+
+#include "replay_game_strategy.h"
+#include "../../serializer.h"
+
+/**
+ * @brief Settings and results of the replays.
+ */
+struct replay_state {
+    char **files;
+    int count;
+    double speed;
+
+    long played;
+    long failed;
+    long commands;
+};
+
+static char *replay_default_files[] = { REPLAY_DEFAULT_FILE };
+
+static struct replay_state replay = { replay_default_files, 1, 0.0, 0, 0, 0 };
+
+
+void set_replay_files(char **files, int count) {
+    if (count > 0) {
+        replay.files = files;
+        replay.count = count;
+    } else {
+        replay.files = replay_default_files;
+        replay.count = 1;
+    }
+}
+
+void set_replay_speed(double speed) {
+    replay.speed = speed > 0 ? speed : 0.0;
+}
+
+void display_replay_game_screen(struct game_config *config) {
+    if (replay.speed > 0)
+        display_console_game_screen(config);
+}
+
+void user_replay_game_input(struct game_config *config) {
+    (void) config;
+}
+
+void end_replay_game_message(struct game_config *config) {
+    (void) config;
+}
+
+/**
+ * @brief Shows the field after a command and waits for the next one.
+ */
+static void show_replay_step(struct game_config *config) {
+    struct timespec delay;
+    double seconds;
+
+    config->output->display_game(config);
+
+    seconds = 1.0 / replay.speed;
+    delay.tv_sec = (time_t) seconds;
+    delay.tv_nsec = (long) ((seconds - (double) delay.tv_sec) * 1e9);
+    nanosleep(&delay, NULL);
+}
+
+/**
+ * @brief Plays a replay file and prints its result.
+ */
+static void play_replay_file(struct game_config *config, const char *file_name) {
+    game_replay_result result;
+    unsigned char *data;
+    size_t size;
+    int verified;
+
+    if ((data = read_game_save_file(file_name, &size)) == NULL) {
+        printf("%s: cannot be read\n", file_name);
+        verified = 0;
+    } else {
+        if (replay.speed > 0 && system("clear") != 0)
+            printf("Error while console clearing\n");
+
+        verified = play_game_replay(config, data, size, replay.speed > 0 ? show_replay_step : NULL, &result);
+        free(data);
+
+        printf("%s: %s, %ld commands, score %d (recorded %d), hash %08lx (recorded %08lx)%s%s\n",
+               file_name, verified ? "verified" : "MISMATCH", result.commands,
+               result.score, result.expected_score, result.hash, result.expected_hash,
+               result.complete ? "" : ", no end record", result.diverged ? ", a command was refused" : "");
+
+        replay.commands += result.commands;
+    }
+
+    replay.played++;
+    if (!verified)
+        replay.failed++;
+}
+
+/**
+ * @brief Seconds elapsed since @p start.
+ */
+static double get_replay_elapsed_time(const struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void show_replay_game_menu(struct game_config *config) {
+    struct timespec start;
+    double elapsed;
+    int i;
+
+    /* the boards come from the replays and nothing is saved */
+    config->autosave = 0;
+    config->solvable_boards = 0;
+
+    replay.played = 0;
+    replay.failed = 0;
+    replay.commands = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < replay.count; i++) {
+        play_replay_file(config, replay.files[i]);
+    }
+
+    elapsed = get_replay_elapsed_time(&start);
+
+    if (config->field != NULL) {
+        game_field_free(config->field);
+        config->field = NULL;
+    }
+
+    printf("replays: %ld, failed: %ld\n", replay.played, replay.failed);
+    printf("commands: %ld\n", replay.commands);
+    printf("time: %.3f s\n", elapsed);
+    printf("commands per second: %.0f\n", elapsed > 0 ? replay.commands / elapsed : 0.0);
+
+    if (replay.failed > 0)
+        exit(EXIT_FAILURE);
+}
+
+void show_replay_game_message(const char *text) {
+    fprintf(stderr, "%s\n", text);
+}
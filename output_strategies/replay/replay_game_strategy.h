@@ -0,0 +1,75 @@
+/**
+ * @file replay_game_strategy.h
+ * @brief Output strategy playing recorded games again (see game_replay.h).
+ *
+ * The menu of this strategy plays each replay file through the engine and
+ * checks that it ends with the score and the field hash it recorded. By
+ * default nothing is shown and the commands are played as fast as the
+ * engine goes; with a speed, the console screen is drawn after each
+ * command, at that number of commands per second.
+ *
+ * The program ends with a failure status if a replay does not verify, so
+ * that a set of replays can check the rules after a change.
+ */
+
+#ifndef _REPLAY_GAME_STRATEGY_H
+#define _REPLAY_GAME_STRATEGY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../game.h"
+#include "../../game_config.h"
+#include "../output_config.h"
+
+/**
+ * @brief Replay played when no file is given.
+ */
+#define REPLAY_DEFAULT_FILE "replay.bin"
+
+/**
+ * @brief Sets the replays to play.
+ * @param files Paths of the replays; kept, not copied.
+ * @param count Number of paths; REPLAY_DEFAULT_FILE is played if 0.
+ */
+void set_replay_files(char **files, int count);
+
+/**
+ * @brief Sets the speed of the replays.
+ * @param speed Commands shown per second, or 0 to play as fast as possible without showing them.
+ */
+void set_replay_speed(double speed);
+
+/**
+ * @brief Draws the field on the console when the replays are shown.
+ * @param config Pointer to the game_config structure.
+ */
+void display_replay_game_screen(struct game_config *config);
+
+/**
+ * @brief Does nothing: the commands come from the replay.
+ * @param config Pointer to the game_config structure.
+ */
+void user_replay_game_input(struct game_config *config);
+
+/**
+ * @brief Does nothing: the result of each replay is printed by the menu.
+ * @param config Pointer to the game_config structure.
+ */
+void end_replay_game_message(struct game_config *config);
+
+/**
+ * @brief Plays the replays, prints the result of each one and the number of
+ *        commands per second, and exits with a failure if one does not verify.
+ * @param config Pointer to the game_config structure.
+ */
+void show_replay_game_menu(struct game_config *config);
+
+/**
+ * @brief Prints the message on the standard error.
+ * @param text Message string.
+ */
+void show_replay_game_message(const char *text);
+
+#endif /* _REPLAY_GAME_STRATEGY_H */
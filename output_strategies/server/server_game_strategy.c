@@ -0,0 +1,694 @@
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "server_game_strategy.h"
+
+/* epoll events handled per turn of the loop */
+#define SERVER_EVENTS_MAX 256
+/* bytes of the longest request: type and payload */
+#define SERVER_REQUEST_MAX 5
+/* bytes received from a client and not yet applied */
+#define SERVER_INPUT_MAX (16 * SERVER_REQUEST_MAX)
+/* unsent bytes past which a client is no longer read nor answered */
+#define SERVER_OUTPUT_MAX 65536
+/* bytes before the payload of a response: type and length */
+#define SERVER_HEADER_SIZE 5
+/* milliseconds before accepting again when no file was left for a client */
+#define SERVER_ACCEPT_PAUSE 100
+
+/**
+ * @brief Bytes received from or waiting to be sent to a client.
+ */
+struct server_buffer {
+    unsigned char* items;
+    size_t count;
+    size_t capacity;
+};
+typedef struct server_buffer server_buffer;
+
+#define VECTOR_TYPE unsigned char
+#define VECTOR_NAME server_buffer
+#define VECTOR_STRUCT_DEFINED
+#include "../../game_objects/vector.h"
+
+/**
+ * @brief A client and its game.
+ */
+struct server_session {
+    int fd;
+    struct game_config *config;     /* game of the session; its field is NULL until a new game */
+    server_buffer *input;           /* bytes not yet forming a whole request */
+    server_buffer *output;          /* responses of the current turn and the unsent ones */
+    int closing;                    /* the client left or sent garbage */
+    int paused;                     /* whole requests wait in input for the output to drain */
+    unsigned int events;            /* epoll events the socket is watched for */
+    struct server_session *previous;
+    struct server_session *next;
+};
+
+typedef struct server_session server_session;
+
+/**
+ * @brief Settings and statistics of the server.
+ */
+struct server_state {
+    const char *path;
+    server_session *sessions;       /* open sessions */
+    int listener;                   /* listening socket */
+    int accepting;                  /* 0 while the listener is out of the epoll set */
+    long opened;
+    long requests;
+};
+
+static struct server_state server = { SERVER_DEFAULT_PATH, NULL, -1, 0, 0, 0 };
+
+static volatile sig_atomic_t server_interrupted = 0;
+
+
+static void interrupt_server(int signal_number) {
+    (void) signal_number;
+    server_interrupted = 1;
+}
+
+void set_server_path(const char *path) {
+    server.path = path != NULL ? path : SERVER_DEFAULT_PATH;
+}
+
+void display_server_game_screen(struct game_config *config) {
+    (void) config;
+}
+
+void user_server_game_input(struct game_config *config) {
+    (void) config;
+}
+
+void end_server_game_message(struct game_config *config) {
+    (void) config;
+}
+
+void show_server_game_message(const char *text) {
+    fprintf(stderr, "%s\n", text);
+}
+
+/**
+ * @brief Appends a number in @p size little-endian bytes.
+ */
+static void write_server_number(server_buffer *buffer, unsigned long value, int size) {
+    int i;
+
+    server_buffer_reserve(buffer, buffer->count + size);
+    for (i = 0; i < size; i++) {
+        buffer->items[buffer->count++] = (unsigned char) (value >> (8 * i) & 0xFF);
+    }
+}
+
+static unsigned long read_server_number(const unsigned char *bytes, int size) {
+    unsigned long res;
+    int i;
+
+    res = 0;
+    for (i = 0; i < size; i++) {
+        res |= (unsigned long) bytes[i] << (8 * i);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Starts a response; its length is written by end_server_response().
+ *
+ * @return The offset of the response in the buffer.
+ */
+static size_t begin_server_response(server_buffer *buffer, SERVER_RESPONSE type) {
+    size_t res;
+
+    res = buffer->count;
+    write_server_number(buffer, type, 1);
+    write_server_number(buffer, 0, 4);
+
+    return res;
+}
+
+static void end_server_response(server_buffer *buffer, size_t offset) {
+    unsigned long length;
+    int i;
+
+    length = (unsigned long) (buffer->count - offset - SERVER_HEADER_SIZE);
+    for (i = 0; i < 4; i++) {
+        buffer->items[offset + 1 + i] = (unsigned char) (length >> (8 * i) & 0xFF);
+    }
+}
+
+static void write_server_error(server_session *session, SERVER_ERROR_CODE code) {
+    size_t offset;
+
+    offset = begin_server_response(session->output, SERVER_ERROR);
+    write_server_number(session->output, code, 1);
+    end_server_response(session->output, offset);
+}
+
+/**
+ * @brief Appends cells, keeping the flags a client displays.
+ */
+static void write_server_cells(server_buffer *buffer, const field_cell *cells, size_t count) {
+    size_t i;
+
+    server_buffer_reserve(buffer, buffer->count + count);
+    for (i = 0; i < count; i++) {
+        buffer->items[buffer->count++] = cells[i] &
+            (FIELD_CELL_VALUE_MASK | FIELD_CELL_AVAILABLE | FIELD_CELL_HIGHLITED | FIELD_CELL_SELECTED);
+    }
+}
+
+static void write_server_board(server_session *session) {
+    game_field *field;
+    server_buffer *output;
+    size_t offset;
+
+    field = session->config->field;
+    output = session->output;
+
+    offset = begin_server_response(output, SERVER_BOARD);
+    write_server_number(output, field->width, 1);
+    write_server_number(output, field->stage, 2);
+    write_server_number(output, (unsigned long) field->score, 4);
+    write_server_number(output, field->additions_available, 1);
+    write_server_number(output, field->additions_max, 1);
+    write_server_number(output, field->hints_available, 1);
+    write_server_number(output, field->hints_max, 1);
+    write_server_number(output, (unsigned long) field->table->count, 4);
+    write_server_cells(output, field->table->items, field->table->count);
+    end_server_response(output, offset);
+}
+
+static void write_server_events(server_session *session, const game_events *events) {
+    game_field *field;
+    server_buffer *output;
+    const game_event *event;
+    size_t offset;
+    int i;
+
+    field = session->config->field;
+    output = session->output;
+
+    offset = begin_server_response(output, SERVER_EVENTS);
+    write_server_number(output, (unsigned long) field->score, 4);
+    write_server_number(output, field->additions_available, 1);
+    write_server_number(output, field->hints_available, 1);
+    write_server_number(output, field->stage, 2);
+    write_server_number(output, events->count, 1);
+
+    for (i = 0; i < events->count; i++) {
+        event = events->items + i;
+
+        /* no cell is written as x = 255 */
+        write_server_number(output, event->type, 1);
+        write_server_number(output, (unsigned long) event->start.x, 1);
+        write_server_number(output, (unsigned long) event->start.y, 2);
+        write_server_number(output, (unsigned long) event->end.x, 1);
+        write_server_number(output, (unsigned long) event->end.y, 2);
+        write_server_number(output, (unsigned long) event->value, 4);
+
+        /* the appended cells are the last ones of the field */
+        if (event->type == GAME_EVENT_CELLS_ADDED)
+            write_server_cells(output, field->table->items + field->table->count - event->value, event->value);
+    }
+
+    end_server_response(output, offset);
+}
+
+static server_session* create_server_session(int fd) {
+    server_session *res;
+
+    res = (server_session*) malloc(sizeof(server_session));
+
+    res->fd = fd;
+    res->input = server_buffer_create(0);
+    res->output = server_buffer_create(0);
+    res->closing = 0;
+    res->paused = 0;
+    res->events = EPOLLIN;
+
+    /* a session plays without saving, searching or generating boards */
+    res->config = create_game_config();
+    res->config->autosave = 0;
+    res->config->hint_time = 0;
+
+    res->previous = NULL;
+    res->next = server.sessions;
+    if (server.sessions != NULL)
+        server.sessions->previous = res;
+    server.sessions = res;
+    server.opened++;
+
+    return res;
+}
+
+static void free_server_session_game(server_session *session) {
+    if (session->config->field != NULL) {
+        stop_stage_pipeline(&session->config->next_stage);
+        game_field_free(session->config->field);
+        session->config->field = NULL;
+    }
+}
+
+static void close_server_session(server_session *session) {
+    if (session->previous != NULL)
+        session->previous->next = session->next;
+    else
+        server.sessions = session->next;
+    if (session->next != NULL)
+        session->next->previous = session->previous;
+
+    /* closing the socket also removes it from the epoll set */
+    close(session->fd);
+
+    free_server_session_game(session);
+    free_game_config(session->config);
+    server_buffer_free(session->input);
+    server_buffer_free(session->output);
+    free(session);
+}
+
+/**
+ * @brief Draws the board of the next stage, as the pipeline would without
+ *        generating it, so that no session waits for a thread.
+ */
+static void draw_server_stage_board(struct game_config *config) {
+    game_field *board;
+
+    board = create_new_game_field(config->field->width);
+    board->additions_available = config->field->additions_max;
+    split_game_random(&config->field->random, &board->random);
+    init_game_field(board);
+
+    set_stage_pipeline_board(&config->next_stage, board);
+}
+
+static void start_server_game(server_session *session, unsigned long seed, struct game_config *server_config) {
+    struct game_config *config;
+
+    config = session->config;
+    free_server_session_game(session);
+
+    config->field = create_new_game_field(GRID_WIDTH);
+    config->selected_p.x = -1;
+    seed_game_random(&config->field->random, seed != 0 ? seed : next_game_random(&server_config->random));
+
+    init_game_field(config->field);
+    draw_server_stage_board(config);
+
+    write_server_board(session);
+}
+
+static void play_server_command(server_session *session, GAME_COMMAND_TYPE type, vector2i pos) {
+    struct game_config *config;
+    game_command command;
+    game_events events;
+
+    config = session->config;
+
+    command = create_game_command(type, pos);
+    apply_game_command(config, &command, &events);
+    write_server_events(session, &events);
+
+    if (find_game_event(&events, GAME_EVENT_FIELD_CLEARED) != NULL) {
+        command = create_game_command(GAME_COMMAND_NEW_STAGE, pos);
+        if (apply_game_command(config, &command, &events))
+            draw_server_stage_board(config);
+
+        write_server_events(session, &events);
+        write_server_board(session);
+    }
+}
+
+/**
+ * @brief Payload size of a request.
+ *
+ * @return The number of bytes after the first one, or -1 if the request is unknown.
+ */
+static int get_server_request_size(int type) {
+    int res;
+
+    switch (type) {
+    case SERVER_NEW_GAME:
+        res = 4;
+        break;
+    case SERVER_SELECT:
+        res = 3;
+        break;
+    case SERVER_EXPAND: case SERVER_HINT: case SERVER_STATE:
+        res = 0;
+        break;
+    default:
+        res = -1;
+        break;
+    }
+
+    return res;
+}
+
+static void apply_server_request(server_session *session, const unsigned char *request,
+                                 struct game_config *server_config) {
+    vector2i pos;
+
+    server.requests++;
+    pos = create_vector2i(-1, -1);
+
+    if (request[0] == SERVER_NEW_GAME) {
+        start_server_game(session, read_server_number(request + 1, 4), server_config);
+    } else if (session->config->field == NULL) {
+        write_server_error(session, SERVER_NO_GAME);
+    } else {
+        switch (request[0]) {
+        case SERVER_SELECT:
+            pos = create_vector2i((int) request[1], (int) read_server_number(request + 2, 2));
+            play_server_command(session, GAME_COMMAND_SELECT, pos);
+            break;
+        case SERVER_EXPAND:
+            play_server_command(session, GAME_COMMAND_EXPAND, pos);
+            break;
+        case SERVER_HINT:
+            play_server_command(session, GAME_COMMAND_HINT, pos);
+            break;
+        case SERVER_STATE:
+            write_server_board(session);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Applies every whole request received, keeping a partial one for the next turn.
+ *
+ * Stops early while the client has SERVER_OUTPUT_MAX bytes left to read:
+ * the remaining requests are applied once the output drains.
+ */
+static void apply_server_requests(server_session *session, struct game_config *server_config) {
+    server_buffer *input;
+    size_t offset;
+    int size, waiting;
+
+    input = session->input;
+    offset = 0;
+    waiting = 0;
+    session->paused = 0;
+
+    while (!waiting && !session->paused && offset < input->count) {
+        size = get_server_request_size(input->items[offset]);
+
+        if (size < 0) {
+            /* the stream cannot be followed any more */
+            write_server_error(session, SERVER_UNKNOWN_REQUEST);
+            session->closing = 1;
+            offset = input->count;
+        } else if (offset + 1 + size > input->count) {
+            waiting = 1;
+        } else if (session->output->count >= SERVER_OUTPUT_MAX) {
+            session->paused = 1;
+        } else {
+            apply_server_request(session, input->items + offset, server_config);
+            offset += 1 + size;
+        }
+    }
+
+    server_buffer_remove_range(input, 0, offset);
+}
+
+/**
+ * @brief Reads once from a client, at most what fits in SERVER_INPUT_MAX.
+ *
+ * The rest stays in the socket until the next turn, so a client sending
+ * faster than it reads fills its own socket instead of the server memory.
+ */
+static void read_server_session(server_session *session) {
+    server_buffer *input;
+    ssize_t size;
+
+    input = session->input;
+    server_buffer_reserve(input, SERVER_INPUT_MAX);
+
+    /* a paused session may have no room left until its requests are applied */
+    if (!session->closing && input->count < SERVER_INPUT_MAX) {
+        do {
+            size = read(session->fd, input->items + input->count, SERVER_INPUT_MAX - input->count);
+        } while (size < 0 && errno == EINTR);
+
+        if (size > 0)
+            input->count += size;
+        else if (size == 0 || errno != EAGAIN)
+            /* the end of the stream or a failure; what was received is still applied */
+            session->closing = 1;
+    }
+}
+
+/**
+ * @brief Watches the listener again, once a file may be left for a client.
+ */
+static void listen_server_sessions(int epoll_fd) {
+    struct epoll_event event;
+
+    event.events = EPOLLIN;
+    event.data.ptr = NULL;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server.listener, &event);
+    server.accepting = 1;
+}
+
+/**
+ * @brief Writes the responses of the turn, and closes the session once a
+ *        leaving client has them all.
+ *
+ * The socket is watched for reading only while the client is there and
+ * its unsent responses stay under SERVER_OUTPUT_MAX, and for writing while
+ * some are left or requests wait for them to drain.
+ */
+static void flush_server_session(int epoll_fd, server_session *session) {
+    struct epoll_event event;
+    ssize_t size;
+    size_t sent;
+    int done, failed;
+
+    done = 0;
+    failed = 0;
+    sent = 0;
+    while (!done && sent < session->output->count) {
+        size = write(session->fd, session->output->items + sent, session->output->count - sent);
+
+        if (size > 0)
+            sent += size;
+        else if (size < 0 && errno == EINTR)
+            done = 0;
+        else {
+            failed = size < 0 && errno != EAGAIN;
+            done = 1;
+        }
+    }
+
+    /* the unsent bytes move to the front, so the buffer stays within the cap */
+    server_buffer_remove_range(session->output, 0, sent);
+
+    if (failed || (session->closing && !session->paused && session->output->count == 0)) {
+        close_server_session(session);
+
+        if (!server.accepting)
+            listen_server_sessions(epoll_fd);
+    } else {
+        event.events = (!session->closing && session->output->count < SERVER_OUTPUT_MAX ? EPOLLIN : 0)
+                     | (session->output->count > 0 || session->paused ? EPOLLOUT : 0);
+
+        if (event.events != session->events) {
+            event.data.ptr = session;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, session->fd, &event);
+            session->events = event.events;
+        }
+    }
+}
+
+static void set_server_nonblocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void accept_server_sessions(int epoll_fd) {
+    struct epoll_event event;
+    server_session *session;
+    int fd, done;
+
+    done = 0;
+    while (!done) {
+        fd = accept(server.listener, NULL, NULL);
+
+        if (fd >= 0) {
+            set_server_nonblocking(fd);
+            session = create_server_session(fd);
+
+            event.events = EPOLLIN;
+            event.data.ptr = session;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        } else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+            /* the waiting clients would keep the listener ready: it is left out
+             * until a session closes or SERVER_ACCEPT_PAUSE has passed */
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, server.listener, &event);
+            server.accepting = 0;
+            done = 1;
+        } else if (errno != EINTR && errno != ECONNABORTED && errno != EPROTO) {
+            /* EAGAIN: every waiting client was accepted */
+            if (errno != EAGAIN)
+                perror("accept");
+            done = 1;
+        }
+    }
+}
+
+/**
+ * @brief Creates the listening socket.
+ *
+ * @return The socket, or -1 after printing the error.
+ */
+static int open_server_socket(const char *path) {
+    struct sockaddr_un address;
+    int res;
+
+    res = -1;
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+    } else if ((res = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        perror("socket");
+    } else {
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, path);
+
+        /* a socket file left by a previous server */
+        unlink(path);
+
+        if (bind(res, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(res, SOMAXCONN) < 0) {
+            perror(path);
+            close(res);
+            res = -1;
+        } else {
+            set_server_nonblocking(res);
+        }
+    }
+
+    return res;
+}
+
+/**
+ * @brief Allows as many open files as the system lets the process have,
+ *        since every session is one.
+ */
+static void raise_server_file_limit(void) {
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * @brief Seconds elapsed since @p start.
+ */
+static double get_server_elapsed_time(const struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) (now.tv_sec - start->tv_sec) + (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void show_server_game_menu(struct game_config *config) {
+    struct sigaction action, previous_int, previous_term, previous_pipe;
+    struct epoll_event events[SERVER_EVENTS_MAX];
+    server_session *ready[SERVER_EVENTS_MAX];
+    struct timespec start;
+    int epoll_fd, count, ready_count, i;
+    double elapsed;
+
+    server.listener = open_server_socket(server.path);
+    epoll_fd = server.listener >= 0 ? epoll_create(1) : -1;
+
+    if (server.listener >= 0 && epoll_fd < 0) {
+        perror("epoll_create");
+        close(server.listener);
+        unlink(server.path);
+    } else if (server.listener >= 0) {
+        raise_server_file_limit();
+
+        server_interrupted = 0;
+        server.opened = 0;
+        server.requests = 0;
+
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = interrupt_server;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, &previous_int);
+        sigaction(SIGTERM, &action, &previous_term);
+
+        /* a client leaving while it is written to must not stop the server */
+        action.sa_handler = SIG_IGN;
+        sigaction(SIGPIPE, &action, &previous_pipe);
+
+        listen_server_sessions(epoll_fd);
+
+        if (config->solvable_boards)
+            fprintf(stderr, "Boards are not generated for sessions, they are drawn at random\n");
+
+        printf("listening on %s\n", server.path);
+        fflush(stdout);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        while (!server_interrupted) {
+            count = epoll_wait(epoll_fd, events, SERVER_EVENTS_MAX, server.accepting ? -1 : SERVER_ACCEPT_PAUSE);
+
+            /* no session closed during the pause, the files may be held elsewhere */
+            if (count == 0 && !server.accepting)
+                listen_server_sessions(epoll_fd);
+
+            /* read and apply what arrived... */
+            ready_count = 0;
+            for (i = 0; i < count; i++) {
+                if (events[i].data.ptr == NULL) {
+                    accept_server_sessions(epoll_fd);
+                } else {
+                    ready[ready_count] = (server_session*) events[i].data.ptr;
+                    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                        read_server_session(ready[ready_count]);
+                    apply_server_requests(ready[ready_count], config);
+                    ready_count++;
+                }
+            }
+
+            /* ...then answer each client with one write */
+            for (i = 0; i < ready_count; i++) {
+                flush_server_session(epoll_fd, ready[i]);
+            }
+        }
+
+        elapsed = get_server_elapsed_time(&start);
+
+        while (server.sessions != NULL) {
+            close_server_session(server.sessions);
+        }
+        close(epoll_fd);
+        close(server.listener);
+        unlink(server.path);
+
+        sigaction(SIGINT, &previous_int, NULL);
+        sigaction(SIGTERM, &previous_term, NULL);
+        sigaction(SIGPIPE, &previous_pipe, NULL);
+
+        printf("sessions: %ld\n", server.opened);
+        printf("requests: %ld\n", server.requests);
+        printf("time: %.3f s\n", elapsed);
+        printf("requests per second: %.1f\n", elapsed > 0 ? server.requests / elapsed : 0.0);
+    }
+}
@@ -0,0 +1,133 @@
+/**
+ * @file server_game_strategy.h
+ * @brief Output strategy serving many NumberMatch sessions on a Unix socket.
+ *
+ * The menu of this strategy runs a server in a single thread: one epoll
+ * loop accepts clients on a local Unix domain socket and every connection
+ * is a session with its own field and generator, played through the engine
+ * (game_engine.h). Each turn of the loop reads once from every ready client,
+ * applies its complete requests, then writes each client's responses at once.
+ * A client that does not read its responses is no longer read from until
+ * they drain, so its requests wait in its own socket.
+ *
+ * Numbers are little-endian. A request is one byte and a fixed payload:
+ * - @c 'N' new game, 4 bytes: seed, or 0 to draw one from the server's seeds;
+ * - @c 'S' select, 1 byte x and 2 bytes y;
+ * - @c 'E' expand, @c 'H' hint, @c 'T' state: no payload.
+ *
+ * A response is one byte, a 4-byte length and the payload:
+ * - @c 'B' board: width (1), stage (2), score (4), additions and their
+ *   maximum (1 + 1), hints and their maximum (1 + 1), then the number of
+ *   cells (4) and one byte per cell (its value and the AVAILABLE,
+ *   HIGHLITED and SELECTED flags of field_cell.h);
+ * - @c 'V' events: score (4), additions (1), hints (1), stage (2), number
+ *   of events (1), then each event: type (1, GAME_EVENT_TYPE), start x (1)
+ *   and y (2), end x (1) and y (2), value (4). A GAME_EVENT_CELLS_ADDED
+ *   event is followed by its cells, one byte each;
+ * - @c 'X' error, 1 byte: SERVER_ERROR value.
+ *
+ * A new game and a new stage answer with a board; the other requests answer
+ * with the events, which the client applies to its copy of the board. A
+ * cleared field starts the next stage at once: its events are followed by
+ * the events of GAME_COMMAND_NEW_STAGE and the new board.
+ *
+ * Hints show the first pair and boards are drawn at random, even when the
+ * server is asked for solvable boards, since a search or a generation would
+ * stall every session; sessions are never saved.
+ *
+ * When no file is left for a new client, the listener is left out of the
+ * loop until a session closes, or for a tenth of a second.
+ */
+
+#ifndef _SERVER_GAME_STRATEGY_H
+#define _SERVER_GAME_STRATEGY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../game.h"
+#include "../../game_config.h"
+#include "../output_config.h"
+
+/**
+ * @brief Socket the server listens on when no other path is given.
+ */
+#define SERVER_DEFAULT_PATH "numbermatch.sock"
+
+/**
+ * @enum SERVER_REQUEST
+ * @brief First byte of a request.
+ */
+enum SERVER_REQUEST {
+    SERVER_NEW_GAME = 'N',  /**< Start a new game */
+    SERVER_SELECT   = 'S',  /**< Select a cell */
+    SERVER_EXPAND   = 'E',  /**< Use an addition */
+    SERVER_HINT     = 'H',  /**< Use a hint */
+    SERVER_STATE    = 'T'   /**< Send the whole board */
+};
+typedef enum SERVER_REQUEST SERVER_REQUEST;
+
+/**
+ * @enum SERVER_RESPONSE
+ * @brief First byte of a response.
+ */
+enum SERVER_RESPONSE {
+    SERVER_BOARD  = 'B',    /**< Whole board */
+    SERVER_EVENTS = 'V',    /**< Events of a request */
+    SERVER_ERROR  = 'X'     /**< Refused request */
+};
+typedef enum SERVER_RESPONSE SERVER_RESPONSE;
+
+/**
+ * @enum SERVER_ERROR_CODE
+ * @brief Payload of an error response.
+ */
+enum SERVER_ERROR_CODE {
+    SERVER_UNKNOWN_REQUEST = 1, /**< Unknown first byte; the connection is closed */
+    SERVER_NO_GAME         = 2  /**< The session has no game yet */
+};
+typedef enum SERVER_ERROR_CODE SERVER_ERROR_CODE;
+
+/**
+ * @brief Sets the path of the socket the server listens on.
+ * @param path Path of the socket, SERVER_DEFAULT_PATH if NULL.
+ */
+void set_server_path(const char *path);
+
+/**
+ * @brief Does nothing: the sessions are displayed by their clients.
+ * @param config Pointer to the game_config structure.
+ */
+void display_server_game_screen(struct game_config *config);
+
+/**
+ * @brief Does nothing: the sessions are played by their clients.
+ * @param config Pointer to the game_config structure.
+ */
+void user_server_game_input(struct game_config *config);
+
+/**
+ * @brief Does nothing: the clients see the end of their games in the events.
+ * @param config Pointer to the game_config structure.
+ */
+void end_server_game_message(struct game_config *config);
+
+/**
+ * @brief Serves sessions until an interrupt (Ctrl-C or SIGTERM).
+ *
+ * The sessions use the board settings of @p config (solvable boards and
+ * their difficulty) and draw their seeds from @p config->random. The socket
+ * file is removed when the server stops.
+ *
+ * @param config Pointer to the game_config structure.
+ */
+void show_server_game_menu(struct game_config *config);
+
+/**
+ * @brief Prints the message on the standard error of the server.
+ * @param text Message string.
+ */
+void show_server_game_message(const char *text);
+
+#endif /* _SERVER_GAME_STRATEGY_H */
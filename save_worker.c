@@ -0,0 +1,267 @@
+#include<string.h>
+
+#include"save_worker.h"
+#include"serializer.h"
+
+
+void init_save_worker(save_worker *worker) {
+    worker->started = 0;
+    worker->running = 0;
+    worker->stopping = 0;
+    worker->writing = 0;
+    worker->file_name = NULL;
+    worker->log_name = NULL;
+    worker->log_file = NULL;
+    worker->pending = NULL;
+    worker->pending_size = 0;
+    worker->pending_capacity = 0;
+    worker->written = NULL;
+    worker->written_capacity = 0;
+    worker->records = NULL;
+    worker->records_size = 0;
+    worker->records_capacity = 0;
+    worker->appended = NULL;
+    worker->appended_capacity = 0;
+    worker->save_size = 0;
+    worker->log_size = 0;
+    worker->pushed = 0;
+    worker->moves = 0;
+    worker->writes = 0;
+    worker->appends = 0;
+}
+
+static char* copy_save_worker_name(const char *name) {
+    char *res;
+
+    res = NULL;
+
+    if (name != NULL) {
+        res = (char*) malloc(strlen(name) + 1);
+        strcpy(res, name);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Swaps two buffers and their allocated sizes.
+ */
+static void swap_save_worker_buffers(unsigned char **first, size_t *first_capacity,
+                                     unsigned char **second, size_t *second_capacity) {
+    unsigned char *buffer;
+    size_t capacity;
+
+    buffer = *first;
+    capacity = *first_capacity;
+    *first = *second;
+    *first_capacity = *second_capacity;
+    *second = buffer;
+    *second_capacity = capacity;
+}
+
+/**
+ * @brief Replaces the save file, then starts its log.
+ *
+ * The old log is closed first: if the save cannot be written, the moves are
+ * dropped until the next save, since the old save and its log stay whole.
+ */
+static void write_save_worker_file(save_worker *worker, size_t size) {
+    if (worker->log_file != NULL) {
+        fclose(worker->log_file);
+        worker->log_file = NULL;
+    }
+
+    if (write_game_save_file(worker->file_name, worker->written, size) && worker->log_name != NULL)
+        worker->log_file = create_game_log_file(worker->log_name, worker->written, size);
+
+    worker->writes++;
+}
+
+static void append_save_worker_records(save_worker *worker, size_t size) {
+    if (worker->log_file != NULL) {
+        if (fwrite(worker->appended, 1, size, worker->log_file) != size || fflush(worker->log_file) != 0) {
+            printf("Error while serializing game file\nCant write in file: %s\n", worker->log_name);
+            fclose(worker->log_file);
+            worker->log_file = NULL;
+        }
+    }
+
+    worker->appends++;
+}
+
+/**
+ * @brief Writes the pending save, then the records pushed after it, swapping
+ *        the buffers so that the next ones can be pushed during the write.
+ *
+ * Called with the lock held; the lock is released during the write.
+ */
+static void write_save_worker_pending(save_worker *worker) {
+    size_t size, records_size;
+
+    swap_save_worker_buffers(&worker->written, &worker->written_capacity,
+                             &worker->pending, &worker->pending_capacity);
+    swap_save_worker_buffers(&worker->appended, &worker->appended_capacity,
+                             &worker->records, &worker->records_capacity);
+
+    size = worker->pending_size;
+    records_size = worker->records_size;
+    worker->pending_size = 0;
+    worker->records_size = 0;
+    worker->writing = 1;
+
+    pthread_mutex_unlock(&worker->lock);
+
+    if (size > 0)
+        write_save_worker_file(worker, size);
+    if (records_size > 0)
+        append_save_worker_records(worker, records_size);
+
+    pthread_mutex_lock(&worker->lock);
+
+    worker->writing = 0;
+    pthread_cond_broadcast(&worker->changed);
+}
+
+static int check_save_worker_pending(save_worker *worker) {
+    return worker->pending_size > 0 || worker->records_size > 0;
+}
+
+static void* run_save_worker(void *arg) {
+    save_worker *worker;
+
+    worker = (save_worker*) arg;
+
+    pthread_mutex_lock(&worker->lock);
+
+    while (!worker->stopping || check_save_worker_pending(worker)) {
+        if (check_save_worker_pending(worker))
+            write_save_worker_pending(worker);
+        else
+            pthread_cond_wait(&worker->changed, &worker->lock);
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+
+    return NULL;
+}
+
+void start_save_worker(save_worker *worker, const char *file_name, const char *log_name) {
+    init_save_worker(worker);
+
+    worker->file_name = copy_save_worker_name(file_name);
+    worker->log_name = copy_save_worker_name(log_name);
+
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->changed, NULL);
+    worker->started = 1;
+
+    worker->running = pthread_create(&worker->thread, NULL, run_save_worker, worker) == 0;
+}
+
+/**
+ * @brief Hands the pending work to the thread, or writes it without a thread.
+ *
+ * Called with the lock held.
+ */
+static void wake_save_worker(save_worker *worker) {
+    if (worker->running)
+        pthread_cond_broadcast(&worker->changed);
+    else
+        write_save_worker_pending(worker);
+}
+
+/**
+ * @brief Copies the save of a field as the pending one; the records pushed
+ *        before it are part of it and are dropped.
+ *
+ * Called with the lock held.
+ */
+static void copy_save_worker_field(save_worker *worker, game_field *field) {
+    size_t size;
+
+    size = get_game_field_save_size(field);
+
+    if (worker->pending_capacity < size) {
+        free(worker->pending);
+        worker->pending = (unsigned char*) malloc(size);
+        worker->pending_capacity = size;
+    }
+
+    write_game_field_save(field, worker->pending);
+    worker->pending_size = size;
+    worker->records_size = 0;
+    worker->save_size = size;
+    worker->log_size = 0;
+    worker->pushed++;
+}
+
+void push_save_worker(save_worker *worker, game_field *field) {
+    pthread_mutex_lock(&worker->lock);
+
+    copy_save_worker_field(worker, field);
+    wake_save_worker(worker);
+
+    pthread_mutex_unlock(&worker->lock);
+}
+
+void push_save_worker_move(save_worker *worker, game_field *field, const unsigned char *record, size_t size) {
+    pthread_mutex_lock(&worker->lock);
+
+    /* the log is compacted once replaying it would cost more than reading a save */
+    if (worker->log_name == NULL ||
+        (worker->log_size + size > worker->save_size && worker->log_size + size > SAVE_WORKER_LOG_MIN)) {
+        copy_save_worker_field(worker, field);
+    } else {
+        if (worker->records_capacity < worker->records_size + size) {
+            worker->records_capacity = 2 * (worker->records_size + size);
+            worker->records = (unsigned char*) realloc(worker->records, worker->records_capacity);
+        }
+
+        memcpy(worker->records + worker->records_size, record, size);
+        worker->records_size += size;
+        worker->log_size += size;
+        worker->moves++;
+    }
+
+    wake_save_worker(worker);
+
+    pthread_mutex_unlock(&worker->lock);
+}
+
+void flush_save_worker(save_worker *worker) {
+    pthread_mutex_lock(&worker->lock);
+
+    while (worker->running && (check_save_worker_pending(worker) || worker->writing)) {
+        pthread_cond_wait(&worker->changed, &worker->lock);
+    }
+
+    pthread_mutex_unlock(&worker->lock);
+}
+
+void stop_save_worker(save_worker *worker) {
+    if (worker->started) {
+        if (worker->running) {
+            pthread_mutex_lock(&worker->lock);
+            worker->stopping = 1;
+            pthread_cond_broadcast(&worker->changed);
+            pthread_mutex_unlock(&worker->lock);
+
+            pthread_join(worker->thread, NULL);
+            worker->running = 0;
+        }
+
+        if (worker->log_file != NULL)
+            fclose(worker->log_file);
+
+        pthread_mutex_destroy(&worker->lock);
+        pthread_cond_destroy(&worker->changed);
+
+        free(worker->file_name);
+        free(worker->log_name);
+        free(worker->pending);
+        free(worker->written);
+        free(worker->records);
+        free(worker->appended);
+        init_save_worker(worker);
+    }
+}
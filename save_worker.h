@@ -0,0 +1,128 @@
+/**
+ * @file save_worker.h
+ * @brief Writes the autosave of a game in the background.
+ *
+ * Writing "save.bin" on every move costs an open, a write, a sync and a close
+ * on the input thread, which a slow disk or a network home directory turns
+ * into visible latency. The worker takes the save as bytes, which only costs
+ * a copy of the cells, and writes it on its own thread.
+ *
+ * Only the latest save is kept: the saves pushed while a file is written
+ * replace each other, so that a burst of moves costs one more write. Each
+ * file is replaced through a temporary file (see write_game_save_file()).
+ *
+ * With a log, a move only appends its record to the log of the save (see
+ * serializer.h). Once the records pass the size of the save, or
+ * SAVE_WORKER_LOG_MIN bytes for a small board, the next move writes a new
+ * save and starts a new log: loading never replays more than a board's
+ * worth of moves. The log is flushed after each batch of records but not
+ * synced, unlike the save.
+ */
+
+#ifndef SAVE_WORKER_H
+#define SAVE_WORKER_H
+
+#include<stdio.h>
+#include<pthread.h>
+
+#include"game_objects/game_field.h"
+
+/**
+ * @brief Size the log may reach, whatever the size of the save, before it is compacted.
+ */
+#define SAVE_WORKER_LOG_MIN 4096
+
+/**
+ * @brief Autosave of a game, with its writer thread.
+ */
+struct save_worker {
+    pthread_t thread;               /**< Thread writing the saves. */
+    pthread_mutex_t lock;           /**< Guards the members below. */
+    pthread_cond_t changed;         /**< Signalled when a save is pushed or written, and on stop. */
+    int started;                    /**< 1 between start_save_worker() and stop_save_worker(). */
+    int running;                    /**< 1 while the thread has not been joined. */
+    int stopping;                   /**< 1 once the thread is asked to end. */
+    int writing;                    /**< 1 while the thread writes a file. */
+
+    char *file_name;                /**< File the saves go to. */
+    char *log_name;                 /**< File the moves go to, or NULL. */
+    FILE *log_file;                 /**< Log of the last save written, or NULL. */
+    unsigned char *pending;         /**< Latest save not written yet. */
+    size_t pending_size;            /**< Size of the pending save, 0 if there is none. */
+    size_t pending_capacity;        /**< Allocated size of @c pending. */
+    unsigned char *written;         /**< Save being written. */
+    size_t written_capacity;        /**< Allocated size of @c written. */
+    unsigned char *records;         /**< Records pushed after the pending or last save. */
+    size_t records_size;            /**< Size of the records not written yet. */
+    size_t records_capacity;        /**< Allocated size of @c records. */
+    unsigned char *appended;        /**< Records being appended. */
+    size_t appended_capacity;       /**< Allocated size of @c appended. */
+
+    size_t save_size;               /**< Size of the last save pushed. */
+    size_t log_size;                /**< Size of the records pushed since. */
+
+    long pushed;                    /**< Saves pushed. */
+    long moves;                     /**< Records pushed. */
+    long writes;                    /**< Save files written. */
+    long appends;                   /**< Batches of records appended to the log. */
+};
+
+typedef struct save_worker save_worker;
+
+/**
+ * @brief Initializes a stopped worker.
+ *
+ * @param[out] worker Pointer to the worker.
+ */
+void init_save_worker(save_worker *worker);
+
+/**
+ * @brief Starts the thread writing the saves to a file.
+ *
+ * If the thread cannot be created, the saves are written when they are pushed.
+ *
+ * @param[in,out] worker    Pointer to a stopped worker.
+ * @param[in]     file_name File the saves go to, copied.
+ * @param[in]     log_name  File the moves go to, copied, or NULL to save
+ *                          the whole field after every move.
+ */
+void start_save_worker(save_worker *worker, const char *file_name, const char *log_name);
+
+/**
+ * @brief Takes the save of a field, replacing the pending one, and returns.
+ *
+ * @param[in,out] worker Pointer to a started worker.
+ * @param[in]     field  Pointer to the field to save.
+ */
+void push_save_worker(save_worker *worker, game_field *field);
+
+/**
+ * @brief Takes the record of a move played on a field, and returns.
+ *
+ * The field is saved whole instead when the worker has no log or when the
+ * log is due for compaction.
+ *
+ * @param[in,out] worker Pointer to a started worker.
+ * @param[in]     field  Pointer to the field, after the move.
+ * @param[in]     record Bytes of the record (see write_game_log_record()).
+ * @param[in]     size   Number of bytes.
+ */
+void push_save_worker_move(save_worker *worker, game_field *field, const unsigned char *record, size_t size);
+
+/**
+ * @brief Waits until the latest save and records are written.
+ *
+ * @param[in,out] worker Pointer to a started worker.
+ */
+void flush_save_worker(save_worker *worker);
+
+/**
+ * @brief Writes the pending save and records, ends the thread and frees the buffers.
+ *
+ * Does nothing on a stopped worker.
+ *
+ * @param[in,out] worker Pointer to the worker; it is stopped afterwards.
+ */
+void stop_save_worker(save_worker *worker);
+
+#endif /* SAVE_WORKER_H */
@@ -0,0 +1,326 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<unistd.h>
+
+#include"score_board.h"
+#include"serializer.h"
+
+/* magic and version, before the records */
+#define SCORE_BOARD_HEADER_SIZE 5
+
+
+void init_score_board(score_board *board) {
+    board->file_name = NULL;
+    board->writable = 0;
+    board->entries = 0;
+    board->best_count = 0;
+    board->today_count = 0;
+    board->day_start = 0;
+    board->day_end = 0;
+    board->pending_count = 0;
+}
+
+/**
+ * @brief Makes the board of the day the empty board of the local day of a time.
+ *
+ * The bounds of the day are kept so that a game is put on the board, and
+ * the board is checked against the clock, without a date conversion.
+ */
+static void set_score_board_day(score_board *board, unsigned long timestamp) {
+    struct tm *date;
+    struct tm day;
+    time_t value;
+
+    value = (time_t) timestamp;
+
+    if ((date = localtime(&value)) != NULL) {
+        day = *date;
+        day.tm_hour = 0;
+        day.tm_min = 0;
+        day.tm_sec = 0;
+        day.tm_isdst = -1;
+        board->day_start = (unsigned long) mktime(&day);
+
+        day.tm_mday++;
+        day.tm_isdst = -1;
+        board->day_end = (unsigned long) mktime(&day);
+    }
+
+    board->today_count = 0;
+}
+
+/**
+ * @brief Inserts a game in a list of best games, best first, if it belongs there.
+ *
+ * A game ties with the games already in the list after them.
+ */
+static void insert_score_board_entry(score_entry *entries, int *count, const score_entry *entry) {
+    int i;
+
+    i = *count;
+    while (i > 0 && entries[i - 1].score < entry->score) {
+        if (i < SCORE_BOARD_TOP)
+            entries[i] = entries[i - 1];
+        i--;
+    }
+
+    if (i < SCORE_BOARD_TOP) {
+        entries[i] = *entry;
+        if (*count < SCORE_BOARD_TOP)
+            (*count)++;
+    }
+}
+
+/**
+ * @brief Puts a game on the boards, without writing it.
+ */
+static void place_score_board_entry(score_board *board, const score_entry *entry) {
+    insert_score_board_entry(board->best, &board->best_count, entry);
+
+    /* the board of the day starts again with the first game of a new day */
+    if (entry->timestamp >= board->day_end)
+        set_score_board_day(board, entry->timestamp);
+
+    if (entry->timestamp >= board->day_start)
+        insert_score_board_entry(board->today, &board->today_count, entry);
+
+    board->entries++;
+}
+
+static void write_score_board_word(unsigned long value, unsigned char *buffer) {
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        buffer[i] = (unsigned char) (value >> (8 * i) & 0xFF);
+    }
+}
+
+static unsigned long read_score_board_word(const unsigned char *buffer) {
+    unsigned long res;
+    int i;
+
+    res = 0;
+    for (i = 0; i < 4; i++) {
+        res |= (unsigned long) buffer[i] << (8 * i);
+    }
+
+    return res;
+}
+
+static int read_score_board_int(const unsigned char *buffer) {
+    unsigned long value;
+
+    value = read_score_board_word(buffer);
+
+    return value <= 0x7FFFFFFFUL ? (int) value : -(int) (0xFFFFFFFFUL - value) - 1;
+}
+
+static void write_score_board_record(const score_entry *entry, unsigned char *buffer) {
+    write_score_board_word((unsigned long) entry->score & 0xFFFFFFFFUL, buffer);
+    write_score_board_word((unsigned long) entry->stage & 0xFFFFFFFFUL, buffer + 4);
+    write_score_board_word(entry->duration & 0xFFFFFFFFUL, buffer + 8);
+    write_score_board_word(entry->seed & 0xFFFFFFFFUL, buffer + 12);
+    write_score_board_word(entry->timestamp & 0xFFFFFFFFUL, buffer + 16);
+}
+
+static void read_score_board_record(const unsigned char *buffer, score_entry *entry) {
+    entry->score = read_score_board_int(buffer);
+    entry->stage = read_score_board_int(buffer + 4);
+    entry->duration = read_score_board_word(buffer + 8);
+    entry->seed = read_score_board_word(buffer + 12);
+    entry->timestamp = read_score_board_word(buffer + 16);
+}
+
+/**
+ * @brief Cuts a record torn by a crash from the end of the store.
+ */
+static void cut_score_board_file(const char *file_name, size_t size) {
+    FILE *file;
+
+    if ((file = fopen(file_name, "r+")) != NULL) {
+        if (ftruncate(fileno(file), (off_t) size) != 0)
+            printf("Error while serializing scores\nCant cut file: %s\n", file_name);
+        fclose(file);
+    }
+}
+
+/**
+ * @brief Takes in the best score of the file kept before the store.
+ */
+static void import_score_board_legacy(score_board *board) {
+    score_entry entry;
+
+    entry.score = deserialize_game_score(SCORE_BOARD_LEGACY_FILE);
+    entry.stage = 0;
+    entry.duration = 0;
+    entry.seed = 0;
+    entry.timestamp = 0;
+
+    if (entry.score > 0)
+        add_score_board_entry(board, &entry);
+}
+
+/**
+ * @brief Moves a file that is not a store aside, so that a new store replaces it.
+ *
+ * @return 1 if the file was moved, 0 if it is still in the way.
+ */
+static int move_score_board_file(const char *file_name) {
+    char *bad_name;
+    int res;
+
+    bad_name = (char*) malloc(strlen(file_name) + strlen(SCORE_BOARD_BAD_SUFFIX) + 1);
+    strcpy(bad_name, file_name);
+    strcat(bad_name, SCORE_BOARD_BAD_SUFFIX);
+
+    res = rename(file_name, bad_name) == 0;
+
+    if (res)
+        printf("Error while deserializing scores\nNot a score file: %s, moved to %s\n", file_name, bad_name);
+    else
+        printf("Error while deserializing scores\nNot a score file: %s, scores will not be saved\n", file_name);
+
+    free(bad_name);
+
+    return res;
+}
+
+int load_score_board(score_board *board, const char *file_name) {
+    score_entry entry;
+    unsigned char *data;
+    size_t size, position;
+    int res;
+
+    res = 1;
+
+    if (board->file_name == NULL) {
+        set_score_board_day(board, (unsigned long) time(NULL));
+
+        board->file_name = (char*) malloc(strlen(file_name) + 1);
+        strcpy(board->file_name, file_name);
+        board->writable = 1;
+
+        if ((data = read_game_save_file(file_name, &size)) == NULL) {
+            import_score_board_legacy(board);
+        } else if (size < SCORE_BOARD_HEADER_SIZE || memcmp(data, SCORE_BOARD_MAGIC, 4) != 0 ||
+                   data[4] != SCORE_BOARD_VERSION) {
+            board->writable = move_score_board_file(file_name);
+            res = 0;
+        } else {
+            position = SCORE_BOARD_HEADER_SIZE;
+            while (size - position >= SCORE_BOARD_RECORD_SIZE) {
+                read_score_board_record(data + position, &entry);
+                place_score_board_entry(board, &entry);
+                position += SCORE_BOARD_RECORD_SIZE;
+            }
+
+            if (position < size)
+                cut_score_board_file(file_name, position);
+        }
+
+        free(data);
+    }
+
+    return res;
+}
+
+void add_score_board_entry(score_board *board, const score_entry *entry) {
+    place_score_board_entry(board, entry);
+
+    if (board->file_name != NULL) {
+        /* a full batch is only left when it could not be written */
+        if (board->pending_count == SCORE_BOARD_BATCH) {
+            printf("Error while serializing scores\nScore lost: %d\n", board->pending[0].score);
+            memmove(board->pending, board->pending + 1, (SCORE_BOARD_BATCH - 1) * sizeof(score_entry));
+            board->pending_count--;
+        }
+
+        board->pending[board->pending_count++] = *entry;
+
+        if (board->pending_count == SCORE_BOARD_BATCH)
+            flush_score_board(board);
+    }
+}
+
+int flush_score_board(score_board *board) {
+    unsigned char data[SCORE_BOARD_HEADER_SIZE + SCORE_BOARD_BATCH * SCORE_BOARD_RECORD_SIZE];
+    FILE *file;
+    size_t size;
+    long end;
+    int res, i;
+
+    res = 1;
+
+    if (board->pending_count > 0) {
+        if (!board->writable || (file = fopen(board->file_name, "a")) == NULL) {
+            printf("Error while serializing scores\nCant write in file: %s\n", board->file_name);
+            res = 0;
+        } else {
+            size = 0;
+
+            /* a new store starts with its header */
+            fseek(file, 0, SEEK_END);
+            end = ftell(file);
+            if (end == 0) {
+                memcpy(data, SCORE_BOARD_MAGIC, 4);
+                data[4] = SCORE_BOARD_VERSION;
+                size = SCORE_BOARD_HEADER_SIZE;
+            }
+
+            for (i = 0; i < board->pending_count; i++) {
+                write_score_board_record(board->pending + i, data + size);
+                size += SCORE_BOARD_RECORD_SIZE;
+            }
+
+            res = fwrite(data, 1, size, file) == size && fflush(file) == 0;
+
+            /* a part of the batch would shift the records written after it */
+            if (!res && end >= 0 && ftruncate(fileno(file), (off_t) end) != 0)
+                printf("Error while serializing scores\nCant cut file: %s\n", board->file_name);
+
+            res = fclose(file) == 0 && res;
+
+            if (res)
+                board->pending_count = 0;
+            else
+                printf("Error while serializing scores\nCant write in file: %s\n", board->file_name);
+        }
+    }
+
+    return res;
+}
+
+const score_entry* get_score_board_entries(const score_board *board, SCORE_BOARD_PERIOD period, int *count) {
+    const score_entry *res;
+    unsigned long now;
+
+    if (period == SCORE_BOARD_ALL_TIME) {
+        res = board->best;
+        *count = board->best_count;
+    } else {
+        res = board->today;
+        now = (unsigned long) time(NULL);
+        /* the games of the board were played on a day that is over */
+        *count = now >= board->day_start && now < board->day_end ? board->today_count : 0;
+    }
+
+    return res;
+}
+
+int get_score_board_best(const score_board *board, SCORE_BOARD_PERIOD period) {
+    const score_entry *entries;
+    int count;
+
+    entries = get_score_board_entries(board, period, &count);
+
+    return count > 0 ? entries[0].score : 0;
+}
+
+void free_score_board(score_board *board) {
+    flush_score_board(board);
+
+    free(board->file_name);
+    init_score_board(board);
+}
@@ -0,0 +1,180 @@
+/**
+ * @file score_board.h
+ * @brief Keeps the scores of the finished games and their best ones.
+ *
+ * Every finished game appends a record to the store: its score, the stage
+ * it reached, how long it was played, the seed of its boards and when it
+ * ended. The file is only read once, when the board is loaded; the best
+ * SCORE_BOARD_TOP games of all time and of the current day are kept in
+ * memory from then on and updated as games end, so that the menus ask for
+ * them every frame without touching the disk.
+ *
+ * The records are written by batches of SCORE_BOARD_BATCH, and when the
+ * board is flushed or freed, each batch with a single append.
+ *
+ * Layout, numbers on 4 bytes, least significant byte first:
+ * - magic SCORE_BOARD_MAGIC (4), version SCORE_BOARD_VERSION (1);
+ * - the records, SCORE_BOARD_RECORD_SIZE bytes each: score, stage,
+ *   duration in seconds, seed, end time in seconds since the epoch.
+ *
+ * A record torn by a crash is cut from the file when it is loaded. A file
+ * that is not a store is moved to the same name with SCORE_BOARD_BAD_SUFFIX
+ * and a new store is started. The best score of "score.bin", which held
+ * only that score, is taken in as a record when there is no store yet.
+ *
+ * The records that cannot be written are kept for the next batch; once
+ * SCORE_BOARD_BATCH of them wait, the oldest is given up with an error.
+ */
+
+#ifndef SCORE_BOARD_H
+#define SCORE_BOARD_H
+
+/**
+ * @brief First bytes of a store.
+ */
+#define SCORE_BOARD_MAGIC "NMHS"
+
+/**
+ * @brief Version of the stores written.
+ */
+#define SCORE_BOARD_VERSION 1
+
+/**
+ * @brief Size of a record in the store.
+ */
+#define SCORE_BOARD_RECORD_SIZE 20
+
+/**
+ * @brief Number of games kept on each board.
+ */
+#define SCORE_BOARD_TOP 10
+
+/**
+ * @brief Number of records kept in memory before they are appended to the store.
+ */
+#define SCORE_BOARD_BATCH 8
+
+/**
+ * @brief Added to the name of a file that is not a store when it is moved aside.
+ */
+#define SCORE_BOARD_BAD_SUFFIX ".bad"
+
+/**
+ * @brief File the best score was kept in before the store.
+ */
+#define SCORE_BOARD_LEGACY_FILE "score.bin"
+
+/**
+ * @brief Games a board is made of.
+ */
+enum SCORE_BOARD_PERIOD {
+    SCORE_BOARD_ALL_TIME = 0,   /**< Every game of the store */
+    SCORE_BOARD_TODAY = 1       /**< Games ended on the current local day */
+};
+typedef enum SCORE_BOARD_PERIOD SCORE_BOARD_PERIOD;
+
+/**
+ * @brief Record of a finished game.
+ */
+struct score_entry {
+    int score;                  /**< Score at the end of the game. */
+    int stage;                  /**< Stage the game ended on. */
+    unsigned long duration;     /**< Seconds the game was played. */
+    unsigned long seed;         /**< Seed of the game, 32 bits. */
+    unsigned long timestamp;    /**< End of the game, seconds since the epoch. */
+};
+
+typedef struct score_entry score_entry;
+
+/**
+ * @brief Store of the scores with its boards.
+ */
+struct score_board {
+    char *file_name;                            /**< Store, or NULL if none is loaded. */
+    int writable;                               /**< 0 if the store is a file that could not be moved aside. */
+    long entries;                               /**< Records of the store, written or not. */
+
+    score_entry best[SCORE_BOARD_TOP];          /**< Best games of all time, best first. */
+    int best_count;                             /**< Games in @c best. */
+
+    score_entry today[SCORE_BOARD_TOP];         /**< Best games of the day, best first. */
+    int today_count;                            /**< Games in @c today. */
+    unsigned long day_start;                    /**< Start of the local day of @c today. */
+    unsigned long day_end;                      /**< Start of the next day. */
+
+    score_entry pending[SCORE_BOARD_BATCH];     /**< Records not appended to the store yet. */
+    int pending_count;                          /**< Records in @c pending. */
+};
+
+typedef struct score_board score_board;
+
+/**
+ * @brief Initializes an empty board without a store.
+ *
+ * @param[out] board Pointer to the board.
+ */
+void init_score_board(score_board *board);
+
+/**
+ * @brief Loads the boards from a store.
+ *
+ * Once a store is loaded, later calls keep it: the menus load the board
+ * each time they are shown and only the first one reads the file.
+ *
+ * @param[in,out] board     Pointer to the board.
+ * @param[in]     file_name Store; it is created by the first batch if it does not exist.
+ *
+ * @return int 1 if the store was read or does not exist yet, 0 if the file
+ *             was not a store; it is then moved aside, or, if it cannot be,
+ *             the board is kept in memory only.
+ */
+int load_score_board(score_board *board, const char *file_name);
+
+/**
+ * @brief Adds a finished game to the boards and to the records to write.
+ *
+ * @param[in,out] board Pointer to the board; the store is appended to when a batch is full.
+ *                      Without a loaded store the game is only put on the boards.
+ * @param[in]     entry Pointer to the record of the game.
+ */
+void add_score_board_entry(score_board *board, const score_entry *entry);
+
+/**
+ * @brief Appends the records not written yet to the store.
+ *
+ * @param[in,out] board Pointer to the board.
+ *
+ * @return int 1 if the records were written or there were none, 0 otherwise;
+ *             the records are then kept for the next try.
+ */
+int flush_score_board(score_board *board);
+
+/**
+ * @brief Gives the best games of a period.
+ *
+ * @param[in]  board  Pointer to the board.
+ * @param[in]  period Games to give.
+ * @param[out] count  Receives the number of games, SCORE_BOARD_TOP at most.
+ *
+ * @return const score_entry* The games, best first.
+ */
+const score_entry* get_score_board_entries(const score_board *board, SCORE_BOARD_PERIOD period, int *count);
+
+/**
+ * @brief Gives the best score of a period.
+ *
+ * @param[in] board  Pointer to the board.
+ * @param[in] period Games to look at.
+ *
+ * @return int The best score, or 0 if no game ended in the period.
+ */
+int get_score_board_best(const score_board *board, SCORE_BOARD_PERIOD period);
+
+/**
+ * @brief Appends the records not written yet and releases the store.
+ *
+ * @param[in,out] board Pointer to the board; it is empty afterwards.
+ */
+void free_score_board(score_board *board);
+
+#endif /* SCORE_BOARD_H */
@@ -1,156 +1,465 @@
+#include<string.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
 #include"serializer.h"
+#include"game_objects/field_mapping.h"
 
+/* seed and state of the generator, after the cells: five 32-bit words */
+#define RANDOM_SAVE_SIZE 20
 
-int serialize_field_cell(field_cell *cell, FILE* file) {
-    int res;
-    short tmp;
-
-    if (cell != NULL && file != NULL) {
-
-        tmp = cell->value +
-            cell->is_available * 128 +
-            cell->is_highlited * 64 +
-            cell->is_selected * 32 +
-            cell->is_cursor * 16;
-    
-        if(fwrite(&tmp, sizeof(short) / 2, 1, file)) {
-            res = 1;
-        } else {
-            res = 0;
+/* width, stage, score, count, additions and hints, before the cells of an old save */
+#define OLD_SAVE_HEADER_SIZE 10
+
+
+/**
+ * @brief Writes a 32-bit word, least significant byte first.
+ */
+static unsigned char* write_random_word(unsigned long value, unsigned char *buffer) {
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        buffer[i] = (unsigned char) (value >> (8 * i) & 0xFF);
+    }
+
+    return buffer + 4;
+}
+
+static unsigned long read_random_word(const unsigned char *data) {
+    unsigned long res;
+    int i;
+
+    res = 0;
+    for (i = 0; i < 4; i++) {
+        res |= (unsigned long) data[i] << (8 * i);
+    }
+
+    return res;
+}
+
+size_t write_game_save_varint(unsigned long value, unsigned char *buffer) {
+    size_t res;
+
+    res = 0;
+    do {
+        if (buffer != NULL)
+            buffer[res] = (unsigned char) ((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+        value >>= 7;
+        res++;
+    } while (value > 0);
+
+    return res;
+}
+
+/**
+ * @brief Writes the runs of the cells with and without a flag, starting with
+ *        the cells without it, each as a varint.
+ *
+ * @return Number of bytes; nothing is written if @p buffer is NULL.
+ */
+static size_t write_save_plane(const field_cell *cells, int count, field_cell flag, unsigned char *buffer) {
+    size_t res;
+    int i, run;
+    field_cell state;
+
+    res = 0;
+    run = 0;
+    state = 0;
+
+    for (i = 0; i < count; i++) {
+        if ((cells[i] & flag) != state) {
+            res += write_game_save_varint((unsigned long) run, buffer != NULL ? buffer + res : NULL);
+            state ^= flag;
+            run = 0;
         }
-    } else {
-        res = 0;
+        run++;
     }
 
+    if (run > 0)
+        res += write_game_save_varint((unsigned long) run, buffer != NULL ? buffer + res : NULL);
+
     return res;
 }
 
-field_cell deserialize_field_cell(FILE* file) {
-    field_cell res;
-    short tmp;
+/**
+ * @brief Writes the save of a field, or only measures it if @p buffer is NULL.
+ *
+ * @return Number of bytes of the save.
+ */
+static size_t write_game_field_save_data(game_field* field, unsigned char* buffer) {
+    const field_cell *cells;
+    size_t res;
+    int i;
 
-    res.is_selected = 0;
+    cells = field->table->items;
 
-    if (!fread(&tmp, sizeof(short) / 2, 1, file)) {
-        res.value = 0;
-        res.is_available = 0;
-        res.is_highlited = 0;
-    } else {
-        res.value = tmp & 15;
-        res.is_available = tmp / 128;
-        res.is_highlited = tmp / 64 & 1;
-        res.is_selected = tmp / 32 & 1;
-        res.is_cursor = tmp / 16 & 1;
+    if (buffer != NULL) {
+        memcpy(buffer, GAME_SAVE_MAGIC, 4);
+        buffer[4] = GAME_SAVE_VERSION;
+        buffer[5] = GAME_SAVE_LITTLE_ENDIAN;
     }
-    
+    res = 6;
+
+    res += write_game_save_varint(field->width, buffer != NULL ? buffer + res : NULL);
+    res += write_game_save_varint(field->stage, buffer != NULL ? buffer + res : NULL);
+    res += write_game_save_varint((unsigned long) field->score & 0xFFFFFFFFUL, buffer != NULL ? buffer + res : NULL);
+    res += write_game_save_varint((unsigned long) field->count, buffer != NULL ? buffer + res : NULL);
+
+    if (buffer != NULL) {
+        buffer[res] = (unsigned char) (field->additions_max * 16 + field->additions_available);
+        buffer[res + 1] = (unsigned char) (field->hints_max * 16 + field->hints_available);
+
+        write_random_word(field->random.seed, buffer + res + 2);
+        for (i = 0; i < 4; i++) {
+            write_random_word(field->random.state[i], buffer + res + 2 + 4 * (i + 1));
+        }
+    }
+    res += 2 + RANDOM_SAVE_SIZE;
+
+    /* two values a byte, the first one in the low half */
+    if (buffer != NULL) {
+        for (i = 0; i + 1 < field->count; i += 2) {
+            buffer[res + i / 2] = (unsigned char) (FIELD_CELL_VALUE(cells[i]) | FIELD_CELL_VALUE(cells[i + 1]) << 4);
+        }
+        if (i < field->count)
+            buffer[res + i / 2] = (unsigned char) FIELD_CELL_VALUE(cells[i]);
+    }
+    res += ((size_t) field->count + 1) / 2;
+
+    res += write_save_plane(cells, field->count, FIELD_CELL_AVAILABLE, buffer != NULL ? buffer + res : NULL);
+    res += write_save_plane(cells, field->count, FIELD_CELL_HIGHLITED, buffer != NULL ? buffer + res : NULL);
+
     return res;
 }
 
-int serialize_game_field(game_field* field, const char* file_name) {
+size_t get_game_field_save_size(game_field* field) {
+    return write_game_field_save_data(field, NULL);
+}
+
+void write_game_field_save(game_field* field, unsigned char* buffer) {
+    write_game_field_save_data(field, buffer);
+}
+
+int write_game_save_file(const char* file_name, const unsigned char* data, size_t size) {
     FILE* file;
-    int res, i;
-    vector2i pos;
-    unsigned short tmp;
+    char *temp_name;
+    int res;
+
+    temp_name = (char*) malloc(strlen(file_name) + 5);
+    strcpy(temp_name, file_name);
+    strcat(temp_name, ".tmp");
 
-    if ((file = fopen(file_name, "w")) == NULL) {
-        printf("Error while serializing game file\nCant write in file: %s\n", file_name);
+    if ((file = fopen(temp_name, "w")) == NULL) {
+        printf("Error while serializing game file\nCant write in file: %s\n", temp_name);
         res = 0;
     } else {
-        res = 1;
-      
-        fwrite(&field->width, sizeof(unsigned short), 1, file);
-        fwrite(&field->stage, sizeof(unsigned short), 1, file);
-        fwrite(&field->score, sizeof(int) / 2, 1, file);
-        fwrite(&field->count, sizeof(int) / 2, 1, file);
-
-        tmp = field->additions_max * 16 + field->additions_available;
-        fwrite(&tmp, sizeof(unsigned short) / 2, 1, file);
-        
-        tmp = field->hints_max * 16 + field->hints_available;
-        fwrite(&tmp, sizeof(unsigned short) / 2, 1, file);
-
-        for (i = 0; i < field->count; i++) {
-            pos.y = i / field->width;
-            pos.x = i % field->width;
-            
-            serialize_field_cell(get_game_field_cell(field, pos), file);
-        }
+        res = fwrite(data, 1, size, file) == size;
 
+        /* the old save is only replaced by a complete one */
+        if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+            res = 0;
+        if (fclose(file) != 0)
+            res = 0;
 
-        fclose(file);
+        if (res && rename(temp_name, file_name) != 0)
+            res = 0;
+        if (!res) {
+            printf("Error while serializing game file\nCant write in file: %s\n", file_name);
+            remove(temp_name);
+        }
     }
 
+    free(temp_name);
+
     return res;
 }
 
-game_field* deserialize_game_field(const char* file_name) {
-    FILE* file;
-    game_field *res;
-    field_cell *cell;
-    size_t file_size;
-    int i;
-    unsigned short additions_data, hints_data;
+int serialize_game_field(game_field* field, const char* file_name) {
+    unsigned char *data;
+    size_t size;
+    int res;
+
+    size = get_game_field_save_size(field);
+    data = (unsigned char*) malloc(size);
+
+    write_game_field_save(field, data);
+    res = write_game_save_file(file_name, data, size);
+
+    free(data);
+
+    return res;
+}
+
+unsigned char* read_game_save_file(const char* file_name, size_t *size) {
+    FILE *file;
+    unsigned char *res;
+    long file_size;
 
     res = NULL;
-    if ((file = fopen(file_name, "r")) == NULL) {
-        printf("Error while deserializing game file\nCant read from file: %s\n", file_name);
-    } else {
 
+    if ((file = fopen(file_name, "r")) != NULL) {
         fseek(file, 0, SEEK_END);
         file_size = ftell(file);
         fseek(file, 0, SEEK_SET);
-        
-        if (file_size >= 8) {
-
-            res = (game_field*) malloc(sizeof(game_field));
-
-            if (!fread(&res->width, sizeof(unsigned short), 1, file) ||
-                !fread(&res->stage, sizeof(unsigned short), 1, file) ||
-                !fread(&res->score, sizeof(int) / 2, 1, file) ||
-                !fread(&res->count, sizeof(int) / 2, 1, file) ||
-                !fread(&additions_data, sizeof(unsigned short) / 2, 1, file) ||
-                !fread(&hints_data, sizeof(unsigned short) / 2, 1, file) ||
-                (size_t)res->count + 10 != file_size) {
+
+        if (file_size >= 0) {
+            *size = (size_t) file_size;
+            res = (unsigned char*) malloc(*size + 1);
+
+            if (fread(res, 1, *size, file) != *size) {
                 free(res);
                 res = NULL;
-            } else {
-                init_game_field_table(res);
+            }
+        }
 
-                res->additions_max = additions_data / 16 & 15;
-                res->additions_available = additions_data & 15;
+        fclose(file);
+    }
 
-                res->hints_max = hints_data / 16 & 15;
-                res->hints_available = hints_data & 15;
-                
-                for (i = 0; i < res->count; i++) {
+    return res;
+}
 
-                    cell = (field_cell*) malloc(sizeof(field_cell));
-                    *cell = deserialize_field_cell(file);
+/**
+ * @brief Maps a whole save in memory, read only, or reads it if it cannot be mapped.
+ *
+ * @param[out] mapped 1 if the bytes are mapped, 0 if they were read.
+ *
+ * @return The bytes, to be released with release_game_save_file(), or NULL
+ *         if the file cannot be read.
+ */
+static unsigned char* load_game_save_file(const char* file_name, size_t *size, int *mapped) {
+    struct stat st;
+    unsigned char *res;
+    int fd;
 
-                    add_cell_game_field(res, cell);
-                }
-                
+    res = NULL;
+
+    if ((fd = open(file_name, O_RDONLY)) >= 0) {
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            res = (unsigned char*) mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (res == MAP_FAILED)
+                res = NULL;
+            else
+                *size = (size_t) st.st_size;
+        }
+        close(fd);
+    }
+
+    *mapped = res != NULL;
+
+    /* an empty file, or one that cannot be mapped such as a pipe */
+    if (res == NULL)
+        res = read_game_save_file(file_name, size);
+
+    return res;
+}
+
+static void release_game_save_file(unsigned char *data, size_t size, int mapped) {
+    if (mapped)
+        munmap(data, size);
+    else
+        free(data);
+}
+
+int read_game_save_varint(const unsigned char *data, size_t size, size_t *position, unsigned long *value) {
+    int res, shift, more;
+
+    *value = 0;
+    shift = 0;
+    more = 1;
+    res = 1;
+
+    /* a 32-bit number takes at most 5 bytes */
+    while (res && more) {
+        res = *position < size && shift <= 28;
+
+        if (res) {
+            *value |= (unsigned long) (data[*position] & 0x7F) << shift;
+            more = data[*position] & 0x80;
+            (*position)++;
+            shift += 7;
+        }
+    }
+    *value &= 0xFFFFFFFFUL;
+
+    return res;
+}
+
+/**
+ * @brief Sets a flag on the cells from the runs written by write_save_plane().
+ *
+ * @return 1 if the runs cover the cells exactly, 0 otherwise.
+ */
+static int read_save_plane(const unsigned char *data, size_t size, size_t *position,
+                           field_cell *cells, size_t count, field_cell flag) {
+    unsigned long run;
+    size_t number, i;
+    int res, set;
+
+    number = 0;
+    set = 0;
+    res = 1;
+
+    while (res && number < count) {
+        res = read_game_save_varint(data, size, position, &run) && run <= count - number;
+
+        if (res) {
+            for (i = number; set && i < number + run; i++) {
+                cells[i] |= flag;
             }
+            number += run;
+            set = !set;
         }
+    }
 
-        fclose(file);
+    return res;
+}
+
+/**
+ * @brief Builds the field of a save in the format of write_game_field_save().
+ *
+ * @return Pointer to a new game_field, or NULL if the save is invalid.
+ */
+static game_field* read_game_field_save(const unsigned char *data, size_t size) {
+    game_field *res;
+    field_cell *cells;
+    const unsigned char *values;
+    unsigned long width, stage, score, count;
+    size_t position, i;
+    int valid;
+
+    res = NULL;
+    position = 6;
+
+    valid = size >= 6 && data[4] == GAME_SAVE_VERSION && data[5] == GAME_SAVE_LITTLE_ENDIAN &&
+        read_game_save_varint(data, size, &position, &width) &&
+        read_game_save_varint(data, size, &position, &stage) &&
+        read_game_save_varint(data, size, &position, &score) &&
+        read_game_save_varint(data, size, &position, &count) &&
+        width > 0 && width <= 0x7FFF &&
+        position + 2 + RANDOM_SAVE_SIZE <= size &&
+        (count + 1) / 2 <= size - position - 2 - RANDOM_SAVE_SIZE;
+
+    if (valid) {
+        res = create_new_game_field((short) width);
+
+        res->stage = (unsigned short) stage;
+        res->score = score <= 0x7FFFFFFFUL ? (int) score : -(int) (0xFFFFFFFFUL - score) - 1;
+        res->additions_max = data[position] / 16 & 15;
+        res->additions_available = data[position] & 15;
+        res->hints_max = data[position + 1] / 16 & 15;
+        res->hints_available = data[position + 1] & 15;
+        position += 2;
+
+        res->random.seed = read_random_word(data + position);
+        for (i = 0; i < 4; i++) {
+            res->random.state[i] = read_random_word(data + position + 4 * (i + 1));
+        }
+        position += RANDOM_SAVE_SIZE;
+
+        /* the cells are decoded straight into the field, then indexed in one append */
+        cells = reserve_game_field_cells(res, (int) count);
+        values = data + position;
+
+        for (i = 0; i + 1 < count; i += 2) {
+            cells[i] = (field_cell) (values[i / 2] & FIELD_CELL_VALUE_MASK);
+            cells[i + 1] = (field_cell) (values[i / 2] >> 4);
+        }
+        if (i < count)
+            cells[i] = (field_cell) (values[i / 2] & FIELD_CELL_VALUE_MASK);
+        position += (count + 1) / 2;
+
+        valid = read_save_plane(data, size, &position, cells, count, FIELD_CELL_AVAILABLE) &&
+            read_save_plane(data, size, &position, cells, count, FIELD_CELL_HIGHLITED);
+
+        if (valid) {
+            append_game_field_cells(res, (int) count);
+            res->count = (int) count;
+        } else {
+            game_field_free(res);
+            res = NULL;
+        }
     }
 
     return res;
 }
 
-int serialize_game_score(const char* file_name, int value) {
-    FILE *file;
-    int res;
-    
-    file = fopen(file_name, "w");
+/**
+ * @brief Builds the field of a save written before GAME_SAVE_MAGIC, on the
+ *        layout fwrite() gave it on a little-endian machine.
+ *
+ * @return Pointer to a new game_field, or NULL if the save is invalid.
+ */
+static game_field* read_game_field_old_save(const unsigned char *data, size_t size) {
+    game_field *res;
+    size_t count;
+    int i;
 
-    if (file == NULL) {
-        res = 0;
+    res = NULL;
+    count = size >= OLD_SAVE_HEADER_SIZE ? (size_t) (data[6] | data[7] << 8) : 0;
+
+    if ((count + OLD_SAVE_HEADER_SIZE == size || count + OLD_SAVE_HEADER_SIZE + RANDOM_SAVE_SIZE == size) &&
+        (data[0] | data[1] << 8) > 0 && (data[0] | data[1] << 8) <= 0x7FFF) {
+
+        res = create_new_game_field((short) (data[0] | data[1] << 8));
+
+        /* score and count are stored on half an int */
+        res->stage = (unsigned short) (data[2] | data[3] << 8);
+        res->score = data[4] | data[5] << 8;
+
+        res->additions_max = data[8] / 16 & 15;
+        res->additions_available = data[8] & 15;
+
+        res->hints_max = data[9] / 16 & 15;
+        res->hints_available = data[9] & 15;
+
+        /* cells are stored in the file in their memory format */
+        add_cells_game_field(res, data + OLD_SAVE_HEADER_SIZE, (int) count);
+        res->count = (int) count;
+
+        /* saves without a generator continue from a seed taken from their cells */
+        seed_game_random(&res->random, res->hash);
+        if (count + OLD_SAVE_HEADER_SIZE != size) {
+            res->random.seed = read_random_word(data + OLD_SAVE_HEADER_SIZE + count);
+            for (i = 0; i < 4; i++) {
+                res->random.state[i] = read_random_word(data + OLD_SAVE_HEADER_SIZE + count + 4 * (i + 1));
+            }
+        }
+    }
+
+    return res;
+}
+
+game_field* deserialize_game_field_data(const unsigned char *data, size_t size) {
+    game_field *res;
+
+    if (check_field_mapping_file(data, size)) {
+        /* a save written in place by the mmap save mode, see field_mapping.h */
+        res = read_field_mapping(data, size);
+    } else if (size >= 4 && memcmp(data, GAME_SAVE_MAGIC, 4) == 0) {
+        res = read_game_field_save(data, size);
     } else {
-        res = 1;
+        res = read_game_field_old_save(data, size);
+    }
+
+    return res;
+}
 
-        fwrite(&value, sizeof(int), 1, file);
+game_field* deserialize_game_field(const char* file_name) {
+    game_field *res;
+    unsigned char *data;
+    size_t size;
+    int mapped;
+
+    res = NULL;
+
+    /* the whole file is mapped at once and decoded in place */
+    if ((data = load_game_save_file(file_name, &size, &mapped)) == NULL) {
+        printf("Error while deserializing game file\nCant read from file: %s\n", file_name);
+    } else {
+        res = deserialize_game_field_data(data, size);
+        release_game_save_file(data, size, mapped);
     }
 
     return res;
@@ -161,9 +470,155 @@ int deserialize_game_score(const char* file_name) {
     int res;
 
     file = fopen(file_name, "r");
-    if (file == NULL || (fread(&res, sizeof(int), 1, file) == 0)) {
+    if (file == NULL) {
         res = 0;
+    } else {
+        if (fread(&res, sizeof(int), 1, file) == 0)
+            res = 0;
+        fclose(file);
     }
 
     return res;
-}
\ No newline at end of file
+}
+/**
+ * @brief Hashes the bytes of a save (32-bit FNV-1a), to tie a log to it.
+ */
+static unsigned long hash_game_save(const unsigned char *data, size_t size) {
+    unsigned long res;
+    size_t i;
+
+    res = 2166136261UL;
+    for (i = 0; i < size; i++) {
+        res = ((res ^ data[i]) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    return res;
+}
+
+static void write_game_log_header(const unsigned char *save, size_t size, unsigned char *header) {
+    memcpy(header, GAME_LOG_MAGIC, 4);
+    write_random_word(hash_game_save(save, size), header + 4);
+    write_random_word((unsigned long) size, header + 8);
+}
+
+size_t write_game_log_record(GAME_LOG_RECORD type, vector2i start, vector2i end, unsigned char *buffer) {
+    size_t res;
+
+    buffer[0] = (unsigned char) type;
+    res = 1;
+
+    if (type != GAME_LOG_EXPAND) {
+        buffer[1] = (unsigned char) start.x;
+        buffer[2] = (unsigned char) (start.y & 0xFF);
+        buffer[3] = (unsigned char) (start.y >> 8 & 0xFF);
+        buffer[4] = (unsigned char) end.x;
+        buffer[5] = (unsigned char) (end.y & 0xFF);
+        buffer[6] = (unsigned char) (end.y >> 8 & 0xFF);
+        res = GAME_LOG_RECORD_MAX;
+    }
+
+    return res;
+}
+
+FILE* create_game_log_file(const char* log_name, const unsigned char* save, size_t size) {
+    unsigned char header[GAME_LOG_HEADER_SIZE];
+    FILE *res;
+
+    write_game_log_header(save, size, header);
+
+    if ((res = fopen(log_name, "w")) == NULL) {
+        printf("Error while serializing game file\nCant write in file: %s\n", log_name);
+    } else if (fwrite(header, 1, GAME_LOG_HEADER_SIZE, res) != GAME_LOG_HEADER_SIZE || fflush(res) != 0) {
+        printf("Error while serializing game file\nCant write in file: %s\n", log_name);
+        fclose(res);
+        res = NULL;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Plays a move of the log again.
+ *
+ * @return 1 if the record was whole and valid, 0 at the end of the log.
+ */
+static int replay_game_log_record(game_field *field, const unsigned char *record, size_t left, size_t *used) {
+    vector2i start, end;
+    int res;
+
+    res = left >= 1;
+
+    if (res && record[0] != GAME_LOG_EXPAND) {
+        res = left >= GAME_LOG_RECORD_MAX;
+
+        if (res) {
+            start = create_vector2i(record[1], record[2] | record[3] << 8);
+            end = create_vector2i(record[4], record[5] | record[6] << 8);
+            *used = GAME_LOG_RECORD_MAX;
+        }
+    } else {
+        *used = 1;
+    }
+
+    if (res) {
+        switch (record[0]) {
+        case GAME_LOG_MATCH:
+            res = play_game_field_match(field, &start, &end) != NOT_MATCH;
+            break;
+        case GAME_LOG_HINT:
+            res = field->hints_available > 0 && check_match(field, start, end) != NOT_MATCH;
+            if (res) {
+                set_highlight_game_field_cell(field, start, 1);
+                set_highlight_game_field_cell(field, end, 1);
+                field->hints_available--;
+            }
+            break;
+        case GAME_LOG_EXPAND:
+            res = duplicate_game_field_cells(field);
+            break;
+        default:
+            res = 0;
+            break;
+        }
+    }
+
+    return res;
+}
+
+game_field* deserialize_game_save(const char* save_name, const char* log_name) {
+    game_field *res;
+    unsigned char *save, *log, header[GAME_LOG_HEADER_SIZE];
+    size_t save_size, log_size, position, used;
+    int mapped;
+
+    res = NULL;
+    log = NULL;
+
+    if ((save = load_game_save_file(save_name, &save_size, &mapped)) == NULL)
+        printf("Error while deserializing game file\nCant read from file: %s\n", save_name);
+    else
+        res = deserialize_game_field_data(save, save_size);
+
+    if (res != NULL && log_name != NULL &&
+        (log = read_game_save_file(log_name, &log_size)) != NULL &&
+        log_size >= GAME_LOG_HEADER_SIZE) {
+
+        /* a log written for another save, after a crash during a compaction, is stale */
+        write_game_log_header(save, save_size, header);
+
+        if (memcmp(header, log, GAME_LOG_HEADER_SIZE) == 0) {
+            position = GAME_LOG_HEADER_SIZE;
+
+            /* a torn record at the end is the move being written at the crash */
+            while (position < log_size && replay_game_log_record(res, log + position, log_size - position, &used)) {
+                position += used;
+            }
+        }
+    }
+
+    if (save != NULL)
+        release_game_save_file(save, save_size, mapped);
+    free(log);
+
+    return res;
+}
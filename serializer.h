@@ -6,46 +6,159 @@
  * as well as the entire game field. It allows saving the current game progress to a file
  * and loading it back to resume the game.
  *
+ * A save starts with GAME_SAVE_MAGIC, its version and the byte order of its
+ * numbers, so that it can change without breaking the saves already
+ * written. Version GAME_SAVE_VERSION holds, in this order:
+ * - the width, the stage, the score and the number of cells, each as a
+ *   varint (7 bits a byte, least significant first, the high bit telling
+ *   that a byte follows): boards are not limited to 65,535 cells;
+ * - the additions and the hints (1 byte each, max * 16 + available);
+ * - the seed and the state of the generator (5 x 4 bytes, see
+ *   game_random.h), so that the following boards are the ones the game
+ *   would have drawn;
+ * - the values of the cells, two a byte, the first one in the low half;
+ * - the runs of cells without and with FIELD_CELL_AVAILABLE, as varints,
+ *   starting with a run without it, which may be empty; then the runs of
+ *   FIELD_CELL_HIGHLITED in the same way. The cursor and the selection are
+ *   not saved.
+ *
+ * Saves without the magic are read in the format written before: width,
+ * stage, score and count on 2 bytes, additions and hints on 1, then a byte
+ * a cell and the generator, which the oldest saves have not: they get a
+ * seed taken from their cells.
+ *
+ * During a game, the moves are appended to a log next to the save instead
+ * of rewriting it: a match or a hint is 7 bytes and an addition 1, whatever
+ * the size of the board. The log starts with a header naming the save it
+ * follows (magic, hash and size of the save), so that a log left behind by
+ * a crash between writing a new save and starting its log is ignored.
+ *
  */
 
+#ifndef _SERIALIZER_H
+#define _SERIALIZER_H
+
 #include<stdlib.h>
 #include<stdio.h>
 
 #include"game_config.h"
 
 /**
- * @brief Saves a single field cell to a file in a compact format.
+ * @brief First bytes of a save.
+ */
+#define GAME_SAVE_MAGIC "NMSV"
+
+/**
+ * @brief Version of the saves written.
+ */
+#define GAME_SAVE_VERSION 2
+
+/**
+ * @brief Byte order of the numbers of a save: least significant byte first.
+ */
+#define GAME_SAVE_LITTLE_ENDIAN 1
+
+/**
+ * @brief First bytes of a move log.
+ */
+#define GAME_LOG_MAGIC "NMLG"
+
+/**
+ * @brief Size of the header of a move log: magic, hash and size of its save.
+ */
+#define GAME_LOG_HEADER_SIZE 12
+
+/**
+ * @brief Largest size of a move record.
+ */
+#define GAME_LOG_RECORD_MAX 7
+
+/**
+ * @brief First byte of a move record.
+ *
+ * A match and a hint are followed by their two cells, each as x (1 byte)
+ * and y (2 bytes, least significant first); an addition has no payload.
+ */
+enum GAME_LOG_RECORD {
+    GAME_LOG_MATCH  = 'M',  /**< A pair was played */
+    GAME_LOG_HINT   = 'H',  /**< A pair was highlighted */
+    GAME_LOG_EXPAND = 'E'   /**< An addition was used */
+};
+typedef enum GAME_LOG_RECORD GAME_LOG_RECORD;
+
+/**
+ * @brief Gives the size of the save of a field.
+ *
+ * @param[in] field Pointer to the game_field structure to save.
+ *
+ * @return size_t Number of bytes write_game_field_save() writes.
+ */
+size_t get_game_field_save_size(game_field* field);
+
+/**
+ * @brief Writes the save of a field into memory, in its file format.
+ *
+ * @param[in]  field  Pointer to the game_field structure to save.
+ * @param[out] buffer Buffer of get_game_field_save_size() bytes.
+ */
+void write_game_field_save(game_field* field, unsigned char* buffer);
+
+/**
+ * @brief Writes a number as a varint: 7 bits a byte, least significant
+ *        first, the high bit telling that a byte follows.
  *
- * @param[in] cell Pointer to the field_cell structure to serialize.
- * @param[in,out] file Pointer to an already opened file for writing.
+ * @param[in]  value  Number, at most 32 bits.
+ * @param[out] buffer Buffer of at least 5 bytes, or NULL to only measure.
  *
- * @return int Returns 1 if the cell was successfully written, 0 otherwise.
+ * @return size_t Number of bytes of the varint.
  */
-int serialize_field_cell(field_cell *cell, FILE* file);
+size_t write_game_save_varint(unsigned long value, unsigned char *buffer);
 
 /**
- * @brief Loads a single field cell from a file.
+ * @brief Reads a varint written by write_game_save_varint().
  *
- * @param[in,out] file Pointer to an already opened file for reading.
+ * @param[in]     data     Bytes being read.
+ * @param[in]     size     Number of bytes.
+ * @param[in,out] position Offset of the varint, moved past it.
+ * @param[out]    value    Number read.
  *
- * @return field_cell Returns a field_cell structure with values read from the file,
- *                    or a default empty cell if reading fails.
+ * @return int Returns 1 if the varint was whole, 0 otherwise.
  */
-field_cell deserialize_field_cell(FILE* file);
+int read_game_save_varint(const unsigned char *data, size_t size, size_t *position, unsigned long *value);
+
+/**
+ * @brief Writes a save to a file, replacing the previous one at once.
+ *
+ * The data goes to @p file_name with ".tmp" appended, is synced to the disk,
+ * and the temporary file is then renamed over @p file_name: a crash in the
+ * middle leaves the previous save whole.
+ *
+ * @param[in] file_name Path to the output file.
+ * @param[in] data      Bytes of the save.
+ * @param[in] size      Number of bytes.
+ *
+ * @return int Returns 1 if the file was replaced, 0 otherwise.
+ */
+int write_game_save_file(const char* file_name, const unsigned char* data, size_t size);
 
 /**
  * @brief Saves the current game field state to a file.
  *
+ * The file is replaced as write_game_save_file() does.
+ *
  * @param[in] field Pointer to the game_field structure to save.
  * @param[in] file_name Path to the output file.
  *
- * @return int Returns 1 if serialization succeeded, 0 if the file could not be opened for writing.
+ * @return int Returns 1 if serialization succeeded, 0 if the file could not be written.
  */
 int serialize_game_field(game_field* field, const char* file_name);
 
 /**
  * @brief Loads a saved game field state from a file.
  *
+ * The file is read at once; a save of any version, or a save written in
+ * place (see field_mapping.h), is accepted.
+ *
  * @param[in] file_name Path to the file containing serialized game data.
  *
  * @return game_field* Returns a pointer to the newly allocated game_field structure
@@ -54,32 +167,32 @@ int serialize_game_field(game_field* field, const char* file_name);
 game_field* deserialize_game_field(const char* file_name);
 
 /**
- * @brief Serializes and saves the game score to a file.
+ * @brief Builds the field of a save already in memory.
  *
- * This function writes a single integer value (game score) into a file
- * in binary format. If the file cannot be opened, the operation fails.
+ * @param[in] data Bytes of a save of any version, or of a save written in place.
+ * @param[in] size Number of bytes.
  *
- * @param file_name
- *        Path to the file where the score will be saved.
- *
- * @param value
- *        Integer score value to serialize.
+ * @return game_field* The field, or NULL if the save is invalid.
+ */
+game_field* deserialize_game_field_data(const unsigned char* data, size_t size);
+
+/**
+ * @brief Reads a whole file into memory.
  *
- * @return int
- *         - 1 if the score was successfully written.
- *         - 0 if the file could not be opened.
+ * @param[in]  file_name Path to the file.
+ * @param[out] size      Number of bytes read.
  *
- * @note
- * The file is opened in write mode ("w"), which overwrites any existing content.
- * The score is written using fwrite() in binary format.
+ * @return unsigned char* The bytes, to be freed by the caller, or NULL if the
+ *                        file cannot be read.
  */
-int serialize_game_score(const char* file_name, int value);
+unsigned char* read_game_save_file(const char* file_name, size_t *size);
 
 /**
  * @brief Loads and deserializes the game score from a file.
  *
  * This function reads a single integer value (game score) from a file
- * previously written using serialize_game_score().
+ * written by an older version of the game, which kept only its best score.
+ * The scores are now kept by score_board.h, which takes this one in.
  *
  * @param file_name
  *        Path to the file containing the serialized score.
@@ -93,4 +206,41 @@ int serialize_game_score(const char* file_name, int value);
  * in binary format. If the file does not exist or cannot be opened,
  * the function returns 0.
  */
-int deserialize_game_score(const char* file_name);
\ No newline at end of file
+int deserialize_game_score(const char* file_name);
+/**
+ * @brief Writes a move record.
+ *
+ * @param[in]  type   Kind of move.
+ * @param[in]  start  First cell of a match or a hint, before the move.
+ * @param[in]  end    Second cell of a match or a hint, before the move.
+ * @param[out] buffer Buffer of at least GAME_LOG_RECORD_MAX bytes.
+ *
+ * @return size_t Number of bytes written.
+ */
+size_t write_game_log_record(GAME_LOG_RECORD type, vector2i start, vector2i end, unsigned char *buffer);
+
+/**
+ * @brief Starts the move log of a save, replacing any previous log.
+ *
+ * @param[in] log_name Path to the log.
+ * @param[in] save     Bytes of the save the log follows, as written to its file.
+ * @param[in] size     Number of bytes of the save.
+ *
+ * @return FILE* The log, open for appending records, or NULL on error.
+ */
+FILE* create_game_log_file(const char* log_name, const unsigned char* save, size_t size);
+
+/**
+ * @brief Loads a save and plays the moves of its log again.
+ *
+ * The log is ignored if it does not exist or follows another save, and its
+ * records are played until the first one that is torn or invalid.
+ *
+ * @param[in] save_name Path to the save.
+ * @param[in] log_name  Path to the log, or NULL to load the save alone.
+ *
+ * @return game_field* The field, or NULL if the save cannot be loaded.
+ */
+game_field* deserialize_game_save(const char* save_name, const char* log_name);
+
+#endif /* _SERIALIZER_H */
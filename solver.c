@@ -0,0 +1,477 @@
+#include<string.h>
+#include<pthread.h>
+#include<unistd.h>
+
+#include"solver.h"
+#include"game_objects/field_hash.h"
+#include"game_objects/transposition_table.h"
+
+/* explored positions a worker accumulates before reporting them */
+#define SOLVER_NODES_BATCH 1024
+
+/**
+ * @brief A subtree waiting to be explored.
+ */
+struct solver_task {
+    game_field *field;
+};
+
+typedef struct solver_task solver_task;
+
+/**
+ * @brief Deque of tasks: the owner works at the bottom, thieves at the top.
+ */
+struct solver_deque {
+    solver_task *items;
+    int top;
+    int bottom;
+    int capacity;
+    pthread_mutex_t lock;
+};
+
+typedef struct solver_deque solver_deque;
+
+struct solver_shared;
+
+/**
+ * @brief State of one thread; results are merged once every thread ended.
+ */
+struct solver_worker {
+    solver_deque deque;
+    struct solver_shared *shared;
+    pthread_t thread;
+    int index;
+
+    long nodes;
+    long batch;
+    int clearable;
+    int best_score;
+};
+
+typedef struct solver_worker solver_worker;
+
+/**
+ * @brief State shared by all the workers of a search.
+ */
+struct solver_shared {
+    solver_worker *workers;
+    int threads;
+    const solver_options *options;
+    transposition_table *table;     /* results of the positions already solved, or NULL */
+
+    pthread_mutex_t lock;   /* guards idle, active, done and nodes */
+    pthread_cond_t wake;    /* signaled when tasks are shared or the search ends */
+    volatile int idle;      /* workers waiting for a task, read without the lock to share work */
+    int active;             /* workers started */
+    int done;               /* set once every worker waits and every deque is empty */
+    long nodes;             /* positions reported by the workers */
+    volatile int stop;      /* set once the node limit is reached */
+};
+
+typedef struct solver_shared solver_shared;
+
+
+void init_solver_options(solver_options *options) {
+    options->threads = 0;
+    options->max_nodes = 0;
+    options->table_bits = 20;
+}
+
+static void init_solver_deque(solver_deque *deque) {
+    deque->items = NULL;
+    deque->top = 0;
+    deque->bottom = 0;
+    deque->capacity = 0;
+    pthread_mutex_init(&deque->lock, NULL);
+}
+
+static void free_solver_deque(solver_deque *deque) {
+    free(deque->items);
+    pthread_mutex_destroy(&deque->lock);
+}
+
+static void push_solver_deque(solver_deque *deque, solver_task task) {
+    pthread_mutex_lock(&deque->lock);
+
+    /* the space freed by thefts is reclaimed before growing */
+    if (deque->bottom == deque->capacity && deque->top > 0) {
+        memmove(deque->items, deque->items + deque->top,
+                (deque->bottom - deque->top) * sizeof(solver_task));
+        deque->bottom -= deque->top;
+        deque->top = 0;
+    }
+
+    if (deque->bottom == deque->capacity) {
+        deque->capacity = deque->capacity ? deque->capacity * 2 : 16;
+        deque->items = (solver_task*) realloc(deque->items, deque->capacity * sizeof(solver_task));
+    }
+
+    deque->items[deque->bottom++] = task;
+
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/**
+ * @brief Takes the newest task (owner) or the oldest one (thief).
+ */
+static int take_solver_deque(solver_deque *deque, solver_task *task, int steal) {
+    int res;
+
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->top == deque->bottom) {
+        res = 0;
+    } else {
+        if (steal)
+            *task = deque->items[deque->top++];
+        else
+            *task = deque->items[--deque->bottom];
+
+        if (deque->top == deque->bottom) {
+            deque->top = 0;
+            deque->bottom = 0;
+        }
+        res = 1;
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+
+    return res;
+}
+
+static int count_solver_deque(solver_deque *deque) {
+    int res;
+
+    pthread_mutex_lock(&deque->lock);
+    res = deque->bottom - deque->top;
+    pthread_mutex_unlock(&deque->lock);
+
+    return res;
+}
+
+static void push_solver_task(solver_worker *worker, game_field *field) {
+    solver_task task;
+
+    task.field = field;
+    push_solver_deque(&worker->deque, task);
+}
+
+/**
+ * @brief Tells whether the worker should share the moves left at its position:
+ *        some worker waits and nothing is left to steal from this one.
+ */
+static int check_solver_split(solver_worker *worker) {
+    return worker->shared->idle > 0 && count_solver_deque(&worker->deque) == 0;
+}
+
+/**
+ * @brief Wakes the waiting workers once tasks were shared.
+ */
+static void wake_solver_workers(solver_shared *shared) {
+    pthread_mutex_lock(&shared->lock);
+    if (shared->idle > 0)
+        pthread_cond_broadcast(&shared->wake);
+    pthread_mutex_unlock(&shared->lock);
+}
+
+/**
+ * @brief Counts a position, reporting them by batches to apply the limit.
+ */
+static void count_solver_node(solver_worker *worker) {
+    solver_shared *shared;
+
+    shared = worker->shared;
+
+    worker->nodes++;
+    if (++worker->batch == SOLVER_NODES_BATCH) {
+        pthread_mutex_lock(&shared->lock);
+        shared->nodes += worker->batch;
+        if (shared->options->max_nodes > 0 && shared->nodes >= shared->options->max_nodes)
+            shared->stop = 1;
+        pthread_mutex_unlock(&shared->lock);
+
+        worker->batch = 0;
+    }
+}
+
+static void record_solver_line(solver_worker *worker, int score, int cleared) {
+    if (score > worker->best_score)
+        worker->best_score = score;
+    if (cleared)
+        worker->clearable = 1;
+}
+
+/**
+ * @brief Key of a position: its cells and the additions left.
+ */
+static unsigned long get_solver_key(game_field *field) {
+    return field->hash ^ mix_field_hash_word(field->additions_available);
+}
+
+static int search_solver_node(solver_worker *worker, game_field *field, int *cleared, int *split);
+
+/**
+ * @brief Explores a child position, or shares it with the other workers.
+ *
+ * @return The score the child can still earn, if explored here, and 0 for
+ *         a shared child, which reports its own lines.
+ */
+static int search_solver_child(solver_worker *worker, game_field *child, int share, int *cleared, int *split) {
+    int res, child_split;
+
+    if (share) {
+        push_solver_task(worker, child);
+        res = 0;
+        *cleared = 0;
+        *split = 1;
+    } else {
+        child_split = 0;
+        res = search_solver_node(worker, child, cleared, &child_split);
+        game_field_free(child);
+        *split |= child_split;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Explores a position.
+ *
+ * Once a worker waits for a task, the moves left at the position are shared
+ * instead of explored here.
+ *
+ * @return The best score that can still be earned from the position; *cleared
+ *         is set if some explored line clears the field, and *split if some
+ *         line below was shared, the score then leaving it out.
+ */
+static int search_solver_node(solver_worker *worker, game_field *field, int *cleared, int *split) {
+    transposition_table *table;
+    field_match *matches;
+    game_field *child;
+    unsigned long key, data;
+    int res, i, number, gain, child_cleared, sharing;
+
+    table = worker->shared->table;
+    key = get_solver_key(field);
+    res = 0;
+    *cleared = 0;
+    sharing = 0;
+
+    count_solver_node(worker);
+
+    if (worker->shared->stop) {
+        /* the search is abandoned, the result is partial */
+    } else if (table != NULL && probe_transposition_table(table, key, &data)) {
+        res = (int) (data >> 1);
+        *cleared = (int) (data & 1);
+    } else if (check_game_field_is_clear(field)) {
+        res = CLEAR_FIELD_MATCH;
+        *cleared = 1;
+    } else {
+        number = find_all_matches(field, NULL, 0);
+        matches = (field_match*) malloc((number + 1) * sizeof(field_match));
+        find_all_matches(field, matches, number);
+
+        for (i = 0; i < number && !worker->shared->stop; i++) {
+            sharing = sharing || check_solver_split(worker);
+
+            child = copy_game_field(field);
+            gain = play_game_field_match(child, &matches[i].start, &matches[i].end);
+            gain += search_solver_child(worker, child, sharing, &child_cleared, split);
+
+            if (gain > res)
+                res = gain;
+            *cleared |= child_cleared;
+        }
+
+        free(matches);
+
+        if (field->additions_available > 0 && !worker->shared->stop) {
+            sharing = sharing || check_solver_split(worker);
+
+            child = copy_game_field(field);
+            duplicate_game_field_cells(child);
+            gain = search_solver_child(worker, child, sharing, &child_cleared, split);
+
+            if (gain > res)
+                res = gain;
+            *cleared |= child_cleared;
+        }
+
+        if (sharing)
+            wake_solver_workers(worker->shared);
+
+        /* only a position explored completely here is worth remembering */
+        if (table != NULL && !*split && !worker->shared->stop)
+            store_transposition_table(table, key, (unsigned long) res << 1 | (unsigned long) *cleared);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Finds a task, in the worker's own deque first, then in the others.
+ */
+static int find_solver_task(solver_worker *worker, solver_task *task) {
+    solver_shared *shared;
+    int res, i;
+
+    shared = worker->shared;
+    res = take_solver_deque(&worker->deque, task, 0);
+
+    for (i = 1; !res && i < shared->threads; i++) {
+        res = take_solver_deque(&shared->workers[(worker->index + i) % shared->threads].deque, task, 1);
+    }
+
+    return res;
+}
+
+/**
+ * @brief Tells whether some deque holds a task.
+ */
+static int check_solver_tasks(solver_shared *shared) {
+    int res, i;
+
+    res = 0;
+    for (i = 0; !res && i < shared->threads; i++) {
+        res = count_solver_deque(&shared->workers[i].deque) > 0;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Sleeps until a task is shared, or every worker waits with nothing
+ *        left to explore.
+ *
+ * @return 1 if the search is over.
+ */
+static int wait_solver_task(solver_shared *shared) {
+    int res;
+
+    pthread_mutex_lock(&shared->lock);
+    shared->idle++;
+
+    /* a task shared after the deques were checked wakes the worker, since
+     * the worker sharing it takes the lock once its tasks are pushed */
+    while (!shared->done && !check_solver_tasks(shared)) {
+        if (shared->idle == shared->active) {
+            shared->done = 1;
+            pthread_cond_broadcast(&shared->wake);
+        } else {
+            pthread_cond_wait(&shared->wake, &shared->lock);
+        }
+    }
+
+    shared->idle--;
+    res = shared->done;
+    pthread_mutex_unlock(&shared->lock);
+
+    return res;
+}
+
+static void* run_solver_worker(void *arg) {
+    solver_worker *worker;
+    solver_task task;
+    int done, gain, cleared, split;
+
+    worker = (solver_worker*) arg;
+
+    done = 0;
+    while (!done) {
+        if (find_solver_task(worker, &task)) {
+            split = 0;
+            gain = search_solver_node(worker, task.field, &cleared, &split);
+            record_solver_line(worker, task.field->score + gain, cleared);
+            game_field_free(task.field);
+        } else {
+            done = wait_solver_task(worker->shared);
+        }
+    }
+
+    return NULL;
+}
+
+int solve_game_field(game_field *field, const solver_options *options, solver_result *result) {
+    solver_shared shared;
+    solver_worker *worker;
+    int res, i, started;
+
+    shared.threads = options->threads;
+    if (shared.threads <= 0)
+        shared.threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (shared.threads <= 0)
+        shared.threads = 1;
+
+    shared.options = options;
+    shared.table = options->table_bits > 0 ? create_transposition_table(options->table_bits) : NULL;
+    shared.idle = 0;
+    shared.active = shared.threads;
+    shared.done = 0;
+    shared.nodes = 0;
+    shared.stop = 0;
+    pthread_mutex_init(&shared.lock, NULL);
+    pthread_cond_init(&shared.wake, NULL);
+
+    shared.workers = (solver_worker*) malloc(shared.threads * sizeof(solver_worker));
+    for (i = 0; i < shared.threads; i++) {
+        worker = shared.workers + i;
+
+        init_solver_deque(&worker->deque);
+        worker->shared = &shared;
+        worker->index = i;
+        worker->nodes = 0;
+        worker->batch = 0;
+        worker->clearable = 0;
+        worker->best_score = field->score;
+    }
+
+    push_solver_task(shared.workers, copy_game_field(field));
+
+    /* the calling thread works as the first worker */
+    started = 1;
+    res = 1;
+    for (i = 1; res && i < shared.threads; i++) {
+        if (pthread_create(&shared.workers[i].thread, NULL, run_solver_worker, shared.workers + i) == 0)
+            started++;
+        else
+            res = 0;
+    }
+
+    /* the search ends once the workers that did start all wait */
+    if (!res) {
+        pthread_mutex_lock(&shared.lock);
+        shared.active = started;
+        pthread_cond_broadcast(&shared.wake);
+        pthread_mutex_unlock(&shared.lock);
+    }
+
+    run_solver_worker(shared.workers);
+
+    for (i = 1; i < started; i++) {
+        pthread_join(shared.workers[i].thread, NULL);
+    }
+
+    result->clearable = 0;
+    result->best_score = field->score;
+    result->nodes = 0;
+    result->complete = !shared.stop;
+
+    for (i = 0; i < shared.threads; i++) {
+        worker = shared.workers + i;
+
+        result->clearable |= worker->clearable;
+        if (worker->best_score > result->best_score)
+            result->best_score = worker->best_score;
+        result->nodes += worker->nodes;
+
+        free_solver_deque(&worker->deque);
+    }
+
+    free(shared.workers);
+    free_transposition_table(shared.table);
+    pthread_cond_destroy(&shared.wake);
+    pthread_mutex_destroy(&shared.lock);
+
+    return res;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file solver.h
+ * @brief Exhaustive multithreaded solver for a NumberMatch game field.
+ *
+ * The solver explores every sequence of moves that can be played from a
+ * field: every valid pair, scored as user_game_select() scores it (match
+ * type plus CLEAR_LINE_MATCH per removed row), and every addition while some
+ * are left. A line of play ends when the field is cleared, which earns
+ * CLEAR_FIELD_MATCH as GAME_COMMAND_NEW_STAGE does, or when no move is left.
+ *
+ * Branches are spread over threads with one work-stealing deque per worker.
+ * A worker explores its subtree depth-first; only when another worker waits
+ * and its own deque is empty does it push the moves left at its position to
+ * the bottom of its deque. It pops them back from there, and waiting workers
+ * steal the oldest, largest subtrees from the top. Each deque has its own
+ * lock; workers with nothing to steal sleep on a condition variable until
+ * tasks are pushed, and the search ends once all of them wait.
+ *
+ * Positions reached again through another move order are not explored
+ * twice: the score they can still earn is kept in a transposition table
+ * shared by the workers and keyed by the field hash and the additions left.
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include"game_objects/game_field.h"
+
+/**
+ * @brief Parameters of a search.
+ */
+struct solver_options {
+    int threads;        /**< Number of worker threads; 0 uses every online core. */
+    long max_nodes;     /**< Positions to explore before giving up; 0 means no limit. */
+    int table_bits;     /**< Base-2 logarithm of the transposition table slots; 0 disables it. */
+};
+
+typedef struct solver_options solver_options;
+
+/**
+ * @brief Outcome of a search.
+ */
+struct solver_result {
+    int clearable;      /**< 1 if some line of play clears the field. */
+    int best_score;     /**< Best final score reached, including the score of the field. */
+    long nodes;         /**< Number of positions explored, the ones found in the table included. */
+    int complete;       /**< 1 if every line was explored, 0 if the node limit stopped the search. */
+};
+
+typedef struct solver_result solver_result;
+
+/**
+ * @brief Fills the options with their default values.
+ *
+ * @param[out] options Pointer to the options to initialize.
+ *
+ * @details
+ * - every online core is used;
+ * - the number of explored positions is not limited;
+ * - the transposition table has 2^20 slots.
+ */
+void init_solver_options(solver_options *options);
+
+/**
+ * @brief Explores every line of play from a field.
+ *
+ * @param[in]  field   Pointer to the game_field to solve; it is not modified.
+ * @param[in]  options Pointer to the search parameters.
+ * @param[out] result  Pointer receiving the outcome.
+ *
+ * @return int Returns 1 if every thread was started, 0 if some could not be and
+ *             the search ran on fewer threads.
+ */
+int solve_game_field(game_field *field, const solver_options *options, solver_result *result);
+
+#endif /* SOLVER_H */
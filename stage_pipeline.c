@@ -0,0 +1,76 @@
+#include"stage_pipeline.h"
+#include"game.h"
+
+
+void init_stage_pipeline(stage_pipeline *pipeline) {
+    pipeline->running = 0;
+    pipeline->board = NULL;
+}
+
+static void* build_stage_board(void *arg) {
+    stage_pipeline *pipeline;
+    game_field *board;
+
+    pipeline = (stage_pipeline*) arg;
+
+    board = create_new_game_field(pipeline->width);
+    board->additions_available = pipeline->additions;
+    board->random = pipeline->random;
+
+    if (pipeline->solvable)
+        generate_game_board(board, INIT_CELLS_COUNT, &pipeline->generator, NULL);
+    else
+        init_game_field(board);
+
+    pipeline->board = board;
+
+    return NULL;
+}
+
+void start_stage_pipeline(stage_pipeline *pipeline, short width, unsigned short additions,
+                          const game_random *random, int solvable, const generator_options *generator) {
+    pipeline->width = width;
+    pipeline->additions = additions;
+    pipeline->random = *random;
+    pipeline->solvable = solvable;
+    pipeline->generator = *generator;
+    pipeline->board = NULL;
+
+    pipeline->running = pthread_create(&pipeline->thread, NULL, build_stage_board, pipeline) == 0;
+
+    if (!pipeline->running)
+        build_stage_board(pipeline);
+}
+
+void wait_stage_pipeline(stage_pipeline *pipeline) {
+    if (pipeline->running) {
+        pthread_join(pipeline->thread, NULL);
+        pipeline->running = 0;
+    }
+}
+
+game_field* take_stage_pipeline_board(stage_pipeline *pipeline) {
+    game_field *res;
+
+    wait_stage_pipeline(pipeline);
+
+    res = pipeline->board;
+    pipeline->board = NULL;
+
+    return res;
+}
+
+void stop_stage_pipeline(stage_pipeline *pipeline) {
+    game_field *board;
+
+    board = take_stage_pipeline_board(pipeline);
+
+    if (board != NULL)
+        game_field_free(board);
+}
+
+void set_stage_pipeline_board(stage_pipeline *pipeline, game_field *board) {
+    stop_stage_pipeline(pipeline);
+
+    pipeline->board = board;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file stage_pipeline.h
+ * @brief Builds the board of the next stage in the background.
+ *
+ * Drawing a board, and above all generating a solvable one (see
+ * board_generator.h), takes time the player would notice at the moment the
+ * field is cleared. The pipeline builds the next board on its own thread as
+ * soon as a stage starts, so that the stage change only takes the finished
+ * board.
+ *
+ * The board is a complete game_field, cells, match index, links and hash
+ * included: the new stage swaps it in place of the cleared field.
+ */
+
+#ifndef STAGE_PIPELINE_H
+#define STAGE_PIPELINE_H
+
+#include<pthread.h>
+
+#include"game_objects/game_field.h"
+#include"board_generator.h"
+
+/**
+ * @brief Next board of a game, being built or finished.
+ */
+struct stage_pipeline {
+    pthread_t thread;               /**< Thread building the board. */
+    int running;                    /**< 1 while the thread has not been joined. */
+    game_field *board;              /**< Finished board, or NULL. */
+
+    short width;                    /**< Width of the board. */
+    unsigned short additions;       /**< Additions the board will be played with. */
+    game_random random;             /**< Generator the board is drawn from. */
+    int solvable;                   /**< 1 to generate a board known to be clearable. */
+    generator_options generator;    /**< Parameters of the board generator. */
+};
+
+typedef struct stage_pipeline stage_pipeline;
+
+/**
+ * @brief Initializes an empty pipeline.
+ *
+ * @param[out] pipeline Pointer to the pipeline.
+ */
+void init_stage_pipeline(stage_pipeline *pipeline);
+
+/**
+ * @brief Starts building the next board.
+ *
+ * If the thread cannot be created, the board is built before returning.
+ *
+ * @param[in,out] pipeline  Pointer to an empty pipeline.
+ * @param[in]     width     Width of the board.
+ * @param[in]     additions Additions the board will be played with.
+ * @param[in]     random    Generator the board is drawn from, copied.
+ * @param[in]     solvable  1 to generate a board known to be clearable.
+ * @param[in]     generator Parameters of the board generator, copied.
+ */
+void start_stage_pipeline(stage_pipeline *pipeline, short width, unsigned short additions,
+                          const game_random *random, int solvable, const generator_options *generator);
+
+/**
+ * @brief Waits until the next board is finished, and keeps it.
+ *
+ * Frees the thread of the pipeline, for callers that hold many pipelines
+ * and do not want finished threads waiting to be joined.
+ *
+ * @param[in,out] pipeline Pointer to a started pipeline.
+ */
+void wait_stage_pipeline(stage_pipeline *pipeline);
+
+/**
+ * @brief Takes the next board, waiting for it if it is not finished yet.
+ *
+ * @param[in,out] pipeline Pointer to a started pipeline; it is empty afterwards.
+ *
+ * @return The board; the caller frees it.
+ */
+game_field* take_stage_pipeline_board(stage_pipeline *pipeline);
+
+/**
+ * @brief Waits for the board being built, if any, and frees it.
+ *
+ * @param[in,out] pipeline Pointer to the pipeline; it is empty afterwards.
+ */
+void stop_stage_pipeline(stage_pipeline *pipeline);
+
+/**
+ * @brief Replaces the next board with a given one.
+ *
+ * Used to play a recorded game again with the boards it had, since a
+ * generated board depends on the time the generator was given.
+ *
+ * @param[in,out] pipeline Pointer to the pipeline.
+ * @param[in]     board    Board taken by the next take_stage_pipeline_board().
+ */
+void set_stage_pipeline_board(stage_pipeline *pipeline, game_field *board);
+
+#endif /* STAGE_PIPELINE_H */